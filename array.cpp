@@ -0,0 +1,253 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "array.h"
+#include "rpn.h"
+#include "operators.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+// ============================================================================
+// REDUCTIONS
+// ============================================================================
+
+// Built for AVX2 as well as the baseline where the toolchain can pick the
+// version for the running CPU at load time
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define RPN_VECTOR_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define RPN_VECTOR_CLONES
+#endif
+
+namespace {
+
+// Lanes of independent partial results: wide enough for two AVX2 registers,
+// and a fixed-order combine so results don't depend on the CPU
+constexpr size_t kLanes = 8;
+
+template <typename Combine>
+inline double treeReduce(const double* values, size_t n, double identity, Combine combine) {
+    double lanes[kLanes];
+    std::fill(lanes, lanes + kLanes, identity);
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        for (size_t j = 0; j < kLanes; ++j) {
+            lanes[j] = combine(lanes[j], values[i + j]);
+        }
+    }
+    for (size_t j = 0; i < n; ++i, ++j) {
+        lanes[j] = combine(lanes[j], values[i]);
+    }
+    for (size_t width = kLanes / 2; width > 0; width /= 2) {
+        for (size_t j = 0; j < width; ++j) {
+            lanes[j] = combine(lanes[j], lanes[j + width]);
+        }
+    }
+    return lanes[0];
+}
+
+}  // namespace
+
+RPN_VECTOR_CLONES
+double arraySum(const double* values, size_t n) {
+    return treeReduce(values, n, 0.0, [](double a, double b) { return a + b; });
+}
+
+RPN_VECTOR_CLONES
+double arrayProduct(const double* values, size_t n) {
+    return treeReduce(values, n, 1.0, [](double a, double b) { return a * b; });
+}
+
+RPN_VECTOR_CLONES
+double arrayMin(const double* values, size_t n) {
+    return treeReduce(values, n, values[0], [](double a, double b) { return b < a ? b : a; });
+}
+
+RPN_VECTOR_CLONES
+double arrayMax(const double* values, size_t n) {
+    return treeReduce(values, n, values[0], [](double a, double b) { return b > a ? b : a; });
+}
+
+// ============================================================================
+// ARRAY TABLE
+// ============================================================================
+double RPNCalculator::makeArray(std::vector<double> values) {
+    auto data = std::make_shared<const std::vector<double>>(std::move(values));
+    std::uint32_t index;
+    if (!freeArrays_.empty()) {
+        index = freeArrays_.back();
+        freeArrays_.pop_back();
+        arrays_[index] = std::move(data);
+    } else {
+        index = static_cast<std::uint32_t>(arrays_.size());
+        arrays_.push_back(std::move(data));
+    }
+    liveArrays_++;
+    return makeArrayHandle(index);
+}
+
+const std::vector<double>* RPNCalculator::getArray(double value) const {
+    if (!isArrayHandle(value)) return nullptr;
+    std::uint32_t index = arrayHandleIndex(value);
+    return index < arrays_.size() ? arrays_[index].get() : nullptr;
+}
+
+// Mark and sweep over everything that can hold a value across lines
+void RPNCalculator::sweepArrays() {
+    std::vector<bool> reachable(arrays_.size(), false);
+    auto mark = [&](double value) {
+        if (isArrayHandle(value) && arrayHandleIndex(value) < reachable.size()) {
+            reachable[arrayHandleIndex(value)] = true;
+        }
+    };
+    for (double value : stack_) mark(value);
+    for (size_t id = 0; id < variableBound_.size(); ++id) {
+        if (variableBound_[id]) mark(variableValues_[id]);
+    }
+    for (const auto& entry : memory_) mark(entry.second);
+    for (const Frame& frame : frames_) {
+        for (double value : frame.registers) mark(value);
+    }
+    mark(lastX_);
+
+    for (size_t index = 0; index < arrays_.size(); ++index) {
+        if (arrays_[index] && !reachable[index]) {
+            arrays_[index].reset();
+            freeArrays_.push_back(static_cast<std::uint32_t>(index));
+            liveArrays_--;
+        }
+    }
+}
+
+// ============================================================================
+// ELEMENT-WISE OPERATORS
+// ============================================================================
+
+// Runs the operator's kernel over whole arrays; a scalar operand is repeated
+// to the array's length.  If the kernel flags an element, the scalar operator
+// is run on it alone to report the error and the operands are left in place.
+bool RPNCalculator::broadcast(const Operator& op) {
+    if (op.type == OperatorType::NULLARY) return false;
+    const bool binary = op.type == OperatorType::BINARY;
+    const double x = stack_.peek(0);
+    const double y = binary ? stack_.peek(1) : 0.0;
+    const std::vector<double>* xs = getArray(x);
+    const std::vector<double>* ys = binary ? getArray(y) : nullptr;
+    if (!xs && !ys) return false;
+
+    if (!op.kernel) {
+        printError("Error: '" + std::string(op.name) + "' does not take arrays");
+        return true;
+    }
+    if (xs && ys && xs->size() != ys->size()) {
+        printError("Error: Array lengths differ (" + std::to_string(ys->size()) + " and " +
+                   std::to_string(xs->size()) + ")");
+        return true;
+    }
+    const size_t n = xs ? xs->size() : ys->size();
+    std::vector<double> xFill, yFill;  // Broadcast scalars
+    if (!xs) {
+        xFill.assign(n, x);
+        xs = &xFill;
+    }
+    if (binary && !ys) {
+        yFill.assign(n, y);
+        ys = &yFill;
+    }
+
+    std::vector<double> result(n);
+    std::vector<unsigned char> fallback(n, 0);
+    op.kernel(*this, binary ? ys->data() : nullptr, xs->data(), result.data(), fallback.data(), n);
+
+    auto failed = std::find(fallback.begin(), fallback.end(), 1);
+    if (failed != fallback.end()) {
+        size_t i = failed - fallback.begin();
+        size_t depth = stack_.size();
+        if (binary) stack_.push((*ys)[i]);
+        stack_.push((*xs)[i]);
+        op.execute(*this, op);
+        while (stack_.size() > depth) stack_.pop();
+        return true;
+    }
+
+    stack_.pop();
+    if (binary) stack_.pop();
+    lastX_ = x;
+    double handle = makeArray(std::move(result));
+    stack_.push(handle);
+    print(handle);
+    stackLiftEnabled_ = true;
+    return true;
+}
+
+// ============================================================================
+// INPUT AND OUTPUT
+// ============================================================================
+void RPNCalculator::loadArray(std::string_view path) {
+    std::string filename(path);
+    if (!workingDir_.empty() && filename[0] != '/') {
+        filename = workingDir_ + "/" + filename;  // Relative to the daemon client
+    }
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        printError("Error: Cannot read '" + std::string(path) + "'");
+        return;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<double> values;
+    static const char* const kSeparators = " \t\n\v\f\r,";
+    size_t pos = 0;
+    while ((pos = text.find_first_not_of(kSeparators, pos)) != std::string::npos) {
+        size_t end = std::min(text.find_first_of(kSeparators, pos), text.size());
+        std::string_view field(text.data() + pos, end - pos);
+        double value;
+        if (parseNumber(field, value) != NumberParse::OK) {
+            printError("Error: '" + std::string(field) + "' in '" + std::string(path) + "' is not a number");
+            return;
+        }
+        values.push_back(value);
+        pos = end;
+    }
+
+    double handle = makeArray(std::move(values));
+    stack_.push(handle);
+    print(handle);
+    stackLiftEnabled_ = true;
+}
+
+// "[1 2 3]" in full up to kShown elements, else "[1 2 3 ... 8 9 10] (10 elements)"
+std::string_view RPNCalculator::formatArray(double handle) const {
+    const size_t kShown = 8;
+    const std::vector<double>* values = getArray(handle);
+    if (!values) return "[?]";
+    const size_t n = values->size();
+    arrayBuffer_ = "[";
+    for (size_t i = 0; i < n; ++i) {
+        if (i > 0) arrayBuffer_ += ' ';
+        if (n > kShown && i == 3) {
+            arrayBuffer_ += "... ";
+            i = n - 3;
+        }
+        arrayBuffer_ += formatNumber((*values)[i]);
+    }
+    arrayBuffer_ += ']';
+    if (n > kShown) {
+        arrayBuffer_ += " (" + std::to_string(n) + " elements)";
+    }
+    return arrayBuffer_;
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Arrays live on the stack and in variables as NaN-boxed handles: a quiet
+// NaN whose top 16 bits are kArrayTag and whose low 32 bits index the
+// calculator's array table.  Hardware and libm NaNs never carry this
+// payload, and array operands are intercepted before any scalar arithmetic
+// could propagate one, so every double with the tag is a handle.
+constexpr std::uint64_t kArrayTag = 0x7ffc;
+
+inline bool isArrayHandle(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return (bits >> 48) == kArrayTag;
+}
+
+inline double makeArrayHandle(std::uint32_t index) {
+    std::uint64_t bits = (kArrayTag << 48) | index;
+    double value;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+inline std::uint32_t arrayHandleIndex(double handle) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &handle, sizeof bits);
+    return static_cast<std::uint32_t>(bits);
+}
+
+// Reductions (array.cpp).  They keep independent partial results in vector
+// lanes and combine them pairwise, so the summation order (and rounding)
+// differs from a left-to-right loop.
+double arraySum(const double* values, size_t n);
+double arrayProduct(const double* values, size_t n);
+double arrayMin(const double* values, size_t n);  // n > 0
+double arrayMax(const double* values, size_t n);  // n > 0
+
+#endif // ARRAY_H
@@ -0,0 +1,212 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "rpn.h"
+#include "operators.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// ============================================================================
+// PARALLEL BATCH EVALUATION
+// ============================================================================
+
+namespace {
+
+// A run of whole input lines and the output they produced
+struct Chunk {
+    std::string input;
+    BufferSink output;
+    bool done = false;
+    int changedBy = -1;  // Worker whose session the chunk changed, if any
+};
+
+}  // namespace
+
+bool RPNCalculator::sameSession(const RPNCalculator& other) const {
+    // Variables compare bitwise: array handles are NaNs
+    auto sameValues = [](const std::vector<double>& a, const std::vector<double>& b) {
+        return a.size() == b.size() &&
+               (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0);
+    };
+    return sameValues(variableValues_, other.variableValues_) &&
+           variableBound_ == other.variableBound_ &&
+           namedMacros_ == other.namedMacros_ &&
+           memory_ == other.memory_ &&
+           angleMode_ == other.angleMode_ && scale_ == other.scale_ &&
+           autobindXYZ_ == other.autobindXYZ_ && localeFormatting_ == other.localeFormatting_ &&
+           quiet_ == other.quiet_ && quietOperators_ == other.quietOperators_ &&
+           profiling_ == other.profiling_ &&
+           recordingName_ == other.recordingName_ && definingOp_ == other.definingOp_ &&
+           frames_.size() == other.frames_.size();
+}
+
+// Input is cut into chunks of whole lines that workers evaluate
+// independently.  Each worker runs its own copy of this calculator (stack,
+// variables, settings) and reads the same immutable registry snapshot.
+// Chunk output is written in input order.
+//
+// A line that changes what later lines see (a variable, temporary operator,
+// setting, or a recording left open) makes every later chunk suspect.  The
+// worker that ran it stops there, and once its chunk is written the rest of
+// the input is evaluated sequentially on that worker's calculator, so the
+// output always matches stream().
+void RPNCalculator::streamParallel(std::FILE* in, unsigned jobs) {
+    loadConfig();
+    streaming_ = true;
+    quiet_ = true;
+    sharedRegistry_ = true;
+
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t kChunkBytes = 256 * 1024;
+    const size_t maxInFlight = jobs * 4;
+
+    std::mutex mutex;
+    std::condition_variable workReady, chunkDone;
+    std::deque<Chunk*> queue;                    // Waiting for a worker
+    std::deque<std::unique_ptr<Chunk>> inOrder;  // Waiting to be written
+    bool finished = false;
+
+    std::vector<RPNCalculator> calcs(jobs, *this);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i) {
+        workers.emplace_back([&, i]() {
+            RPNCalculator& calc = calcs[i];
+            calc.frames_.reserve(128);
+            calc.calls_.reserve(128);
+            calc.profile_.clear();  // Merged back below
+            for (;;) {
+                Chunk* chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    workReady.wait(lock, [&] { return finished || !queue.empty(); });
+                    if (queue.empty()) return;
+                    chunk = queue.front();
+                    queue.pop_front();
+                }
+                calc.out_ = &chunk->output;
+                std::string_view rest(chunk->input);
+                while (!rest.empty()) {
+                    size_t nl = std::min(rest.find('\n'), rest.size());
+                    calc.streamLine(rest.substr(0, nl), false);
+                    rest.remove_prefix(std::min(nl + 1, rest.size()));
+                }
+                bool changed = !calc.sameSession(*this);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunk->done = true;
+                    if (changed) chunk->changedBy = static_cast<int>(i);
+                }
+                chunkDone.notify_all();
+                if (changed) return;  // Keep the session for the sequential tail
+            }
+        });
+    }
+
+    // Write finished chunks from the front; with all set (or too many in
+    // flight) wait for the front chunk instead of stopping at it.  Returns
+    // the worker to continue on after writing a chunk that changed the
+    // session, or -1.
+    auto drain = [&](bool all) -> int {
+        for (;;) {
+            std::unique_ptr<Chunk> ready;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (inOrder.empty()) return -1;
+                if (all || inOrder.size() >= maxInFlight) {
+                    chunkDone.wait(lock, [&] { return inOrder.front()->done; });
+                } else if (!inOrder.front()->done) {
+                    return -1;
+                }
+                ready = std::move(inOrder.front());
+                inOrder.pop_front();
+            }
+            out_->write(ready->output.out);
+            if (!ready->output.err.empty()) {
+                out_->writeError(ready->output.err);
+            }
+            flushOutput();
+            if (ready->changedBy >= 0) return ready->changedBy;
+        }
+    };
+
+    std::string pending;  // Start of a line continued in the next read
+    bool eof = false;
+    int sequential = -1;
+    while (!eof && sequential < 0) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->input = std::move(pending);
+        pending.clear();
+        size_t have = chunk->input.size();
+        chunk->input.resize(have + kChunkBytes);
+        size_t n = std::fread(&chunk->input[have], 1, kChunkBytes, in);
+        chunk->input.resize(have + n);
+        eof = n == 0;
+        if (!eof) {
+            // Hold back the partial last line
+            size_t lastNl = chunk->input.rfind('\n');
+            if (lastNl == std::string::npos) {
+                pending = std::move(chunk->input);
+                continue;
+            }
+            pending.assign(chunk->input, lastNl + 1, std::string::npos);
+            chunk->input.resize(lastNl + 1);
+        }
+        if (chunk->input.empty()) continue;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(chunk.get());
+            inOrder.push_back(std::move(chunk));
+        }
+        workReady.notify_one();
+        sequential = drain(false);
+    }
+    if (sequential < 0) {
+        sequential = drain(true);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        queue.clear();
+    }
+    workReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (sequential >= 0) {
+        // Chunks after the change are evaluated again, in order, on the
+        // calculator that made it; whatever the workers wrote for them is dropped
+        std::string head;
+        for (const auto& chunk : inOrder) {
+            head += chunk->input;
+        }
+        head += pending;
+        inOrder.clear();
+        RPNCalculator& calc = calcs[sequential];
+        calc.out_ = out_;
+        calc.streamInput(in, false, head);
+    }
+    for (const auto& calc : calcs) {
+        mergeProfile(calc);
+    }
+    flushOutput();
+}
@@ -0,0 +1,268 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Microbenchmarks for the interpreter's hot paths.  `make bench` builds and
+// runs them; results go to stdout as JSON so they can be compared by tools.
+//
+//   ./rpn_bench [name...]   Run only the named benchmarks
+
+#include "rpn.h"
+#include "operators.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// ALLOCATION COUNTING
+// ============================================================================
+static std::atomic<unsigned long long> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// ============================================================================
+// HARNESS
+// ============================================================================
+namespace {
+
+// Discards everything the calculator writes
+class NullSink : public OutputSink {
+public:
+    void write(std::string_view) override {}
+    void writeError(std::string_view) override {}
+};
+
+// Keeps a result observable so the work producing it is not optimized away
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Result {
+    const char* name;
+    unsigned long long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// Runs body in batches until kMinTime has passed, after one warm-up batch
+template <typename Body>
+Result measure(const char* name, Body body) {
+    using Clock = std::chrono::steady_clock;
+    const auto kMinTime = std::chrono::milliseconds(300);
+    const unsigned long long kBatch = 1000;
+
+    for (unsigned long long i = 0; i < kBatch; ++i) body();
+
+    unsigned long long iterations = 0;
+    unsigned long long allocations = g_allocations.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (elapsed < kMinTime) {
+        for (unsigned long long i = 0; i < kBatch; ++i) body();
+        iterations += kBatch;
+        elapsed = Clock::now() - start;
+    }
+    allocations = g_allocations.load(std::memory_order_relaxed) - allocations;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    return {name, iterations, ns / iterations, double(allocations) / iterations};
+}
+
+}  // namespace
+
+// ============================================================================
+// WORKLOADS
+// ============================================================================
+class Benchmarks {
+public:
+    Benchmarks() {
+        calc_.setOutput(&sink_);
+        calc_.quiet_ = true;  // Measure evaluation, not result formatting
+    }
+
+    // Whitespace tokenizing and dispatch of a typical statement
+    Result tokenize() {
+        const std::string_view line = "1 2 + 3 * 4 5 - / 6 7 8 9 10 + + + + 2 ^ sqrt";
+        return measure("tokenize", [&] {
+            calc_.processStatement(line);
+            calc_.stack_.clear();
+        });
+    }
+
+    Result parseNumber() {
+        const char* const inputs[] = {"42", "-3.14159", "6.02e23", "1,234,567.89", "0.000125", "x2"};
+        size_t i = 0;
+        return measure("parse_number", [&] {
+            double value = 0;
+            auto parsed = calc_.parseNumber(inputs[i++ % 6], value);
+            keep(parsed);
+            keep(value);
+        });
+    }
+
+    Result formatNumber() {
+        const double values[] = {42, -3.14159265358979, 6.02e23, 1234567.89, 0.000125, 1.0 / 3};
+        size_t i = 0;
+        calc_.localeFormatting_ = true;
+        return measure("format_number", [&] {
+            std::string_view text = calc_.formatNumber(values[i++ % 6]);
+            keep(text);
+        });
+    }
+
+    // Name lookup of built-in operators
+    Result dispatch() {
+        const std::string_view names[] = {"+", "sin", "swap", "sqrt", "km>mi", "atan2", "help", "%ch"};
+        size_t i = 0;
+        return measure("dispatch", [&] {
+            const Operator* op = calc_.registry_->getOperator(names[i++ % 8]);
+            keep(op);
+        });
+    }
+
+    // One call descends a chain of 99 nested user operators, each adding 1
+    // after its callee returns
+    Result recursion() {
+        calc_.registerUserOperator("depth0", "", {"1", "+"});
+        for (int level = 1; level < 99; ++level) {
+            calc_.registerUserOperator("depth" + std::to_string(level), "",
+                                       {"depth" + std::to_string(level - 1), "1", "+"});
+        }
+        calc_.refreshRegistry();
+        const Operator* top = calc_.registry_->getOperator("depth98");
+        return measure("recursion", [&] {
+            top->execute(calc_, *top);
+            calc_.stack_.clear();
+        });
+    }
+
+    // The same chain with each operator a tail call of the next, so the
+    // callee replaces the caller instead of nesting
+    Result tailCalls() {
+        calc_.registerUserOperator("tail0", "", {"1", "+"});
+        for (int level = 1; level < 99; ++level) {
+            calc_.registerUserOperator("tail" + std::to_string(level), "",
+                                       {"tail" + std::to_string(level - 1)});
+        }
+        calc_.refreshRegistry();
+        const Operator* top = calc_.registry_->getOperator("tail98");
+        return measure("tail_calls", [&] {
+            top->execute(calc_, *top);
+            calc_.stack_.clear();
+        });
+    }
+
+    // A user operator whose compiled body is all literals and arithmetic
+    Result vmArithmetic() {
+        calc_.registerUserOperator("poly", "", {"d", "d", "*", "3", "*", "r", "2", "*", "+", "7", "-",
+                                                "0.5", "*", "abs", "sqrt", "1", "+"});
+        calc_.refreshRegistry();
+        const Operator* poly = calc_.registry_->getOperator("poly");
+        return measure("vm_arithmetic", [&] {
+            calc_.stack_.push(1.5);
+            poly->execute(calc_, *poly);
+            keep(calc_.stack_.peek());
+            calc_.stack_.clear();
+        });
+    }
+
+    // 1000 iterations of a counted loop with a comparison and a branch
+    Result countedLoop() {
+        calc_.registerUserOperator("collatz", "", {"1000", "times", "d", "2", "%", "0", "==", "if",
+                                                   "2", "/", "else", "3", "*", "1", "+", "then",
+                                                   "loop"});
+        calc_.refreshRegistry();
+        const Operator* collatz = calc_.registry_->getOperator("collatz");
+        return measure("counted_loop", [&] {
+            calc_.stack_.push(27);
+            collatz->execute(calc_, *collatz);
+            keep(calc_.stack_.peek());
+            calc_.stack_.clear();
+        });
+    }
+
+    // Splitting "5name" style tokens with 1000 user operators registered
+    Result extractOperator() {
+        {
+            OperatorRegistry::Batch batch(OperatorRegistry::instance());
+            calc_.deferCompile_ = true;
+            for (int i = 0; i < 1000; ++i) {
+                calc_.registerUserOperator("uop" + std::to_string(i), "", {"1"});
+            }
+            calc_.deferCompile_ = false;
+        }
+        calc_.refreshRegistry();
+        const std::string_view tokens[] = {"5uop537", "3+", "45tan", "2uop999", "7km>mi", "10plain"};
+        size_t i = 0;
+        return measure("extract_operator", [&] {
+            size_t opStart = 0;
+            std::string_view op = calc_.extractOperator(tokens[i++ % 6], opStart);
+            keep(op);
+            keep(opStart);
+        });
+    }
+
+private:
+    NullSink sink_;
+    RPNCalculator calc_;
+};
+
+// ============================================================================
+// MAIN
+// ============================================================================
+int main(int argc, char* argv[]) {
+    auto selected = [&](const char* name) {
+        if (argc < 2) return true;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], name) == 0) return true;
+        }
+        return false;
+    };
+
+    // Later workloads register operators, so the order is fixed
+    Benchmarks bench;
+    std::vector<Result> results;
+    if (selected("tokenize")) results.push_back(bench.tokenize());
+    if (selected("parse_number")) results.push_back(bench.parseNumber());
+    if (selected("format_number")) results.push_back(bench.formatNumber());
+    if (selected("dispatch")) results.push_back(bench.dispatch());
+    if (selected("recursion")) results.push_back(bench.recursion());
+    if (selected("tail_calls")) results.push_back(bench.tailCalls());
+    if (selected("vm_arithmetic")) results.push_back(bench.vmArithmetic());
+    if (selected("counted_loop")) results.push_back(bench.countedLoop());
+    if (selected("extract_operator")) results.push_back(bench.extractOperator());
+
+    std::printf("{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::printf("    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f}%s\n",
+                    r.name, r.iterations, r.nsPerOp, r.allocsPerOp, i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
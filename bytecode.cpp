@@ -0,0 +1,555 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "bytecode.h"
+#include "array.h"
+#include "rpn.h"
+#include "operators.h"
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// CONTROL FLOW
+// ============================================================================
+
+ControlWord controlWord(std::string_view token) {
+    static const std::pair<std::string_view, ControlWord> kWords[] = {
+        {"if", ControlWord::IF},       {"else", ControlWord::ELSE},   {"then", ControlWord::THEN},
+        {"times", ControlWord::TIMES}, {"loop", ControlWord::LOOP},   {"begin", ControlWord::BEGIN},
+        {"while", ControlWord::WHILE}, {"repeat", ControlWord::REPEAT}};
+    for (const auto& [word, control] : kWords) {
+        if (token == word) return control;
+    }
+    return ControlWord::NONE;
+}
+
+bool opensControl(ControlWord word) {
+    return word == ControlWord::IF || word == ControlWord::TIMES || word == ControlWord::BEGIN;
+}
+
+bool closesControl(ControlWord word) {
+    return word == ControlWord::THEN || word == ControlWord::LOOP || word == ControlWord::REPEAT;
+}
+
+// Matches the control words of a body, setting targets[i] for each one to
+// the index it continues at when it transfers control.  Returns why the
+// first misplaced word does not nest, or empty.
+template <typename TokenAt>
+static std::string matchControlFlow(size_t count, TokenAt tokenAt, std::vector<size_t>& targets) {
+    struct Open {
+        ControlWord word;  // if, times or begin
+        size_t at;
+        size_t middle;     // Its else or while, or count if none yet
+    };
+    std::vector<Open> open;
+    targets.assign(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        ControlWord word = controlWord(tokenAt(i));
+        switch (word) {
+            case ControlWord::NONE:
+                break;
+            case ControlWord::IF:
+            case ControlWord::TIMES:
+            case ControlWord::BEGIN:
+                open.push_back({word, i, count});
+                targets[i] = i + 1;  // begin falls through
+                break;
+            case ControlWord::ELSE:
+                if (open.empty() || open.back().word != ControlWord::IF || open.back().middle != count) {
+                    return "'else' without 'if'";
+                }
+                open.back().middle = i;
+                targets[open.back().at] = i + 1;  // if: false skips to the else branch
+                break;
+            case ControlWord::THEN:
+                if (open.empty() || open.back().word != ControlWord::IF) {
+                    return "'then' without 'if'";
+                }
+                targets[open.back().middle == count ? open.back().at : open.back().middle] = i + 1;
+                targets[i] = i + 1;
+                open.pop_back();
+                break;
+            case ControlWord::LOOP:
+                if (open.empty() || open.back().word != ControlWord::TIMES) {
+                    return "'loop' without 'times'";
+                }
+                targets[open.back().at] = i + 1;  // times: no iterations
+                targets[i] = open.back().at + 1;
+                open.pop_back();
+                break;
+            case ControlWord::WHILE:
+                if (open.empty() || open.back().word != ControlWord::BEGIN || open.back().middle != count) {
+                    return "'while' without 'begin'";
+                }
+                open.back().middle = i;
+                break;
+            case ControlWord::REPEAT:
+                if (open.empty() || open.back().word != ControlWord::BEGIN ||
+                    open.back().middle == count) {
+                    return "'repeat' without 'begin' ... 'while'";
+                }
+                targets[open.back().middle] = i + 1;  // while: false leaves the loop
+                targets[i] = open.back().at + 1;
+                open.pop_back();
+                break;
+        }
+    }
+    if (!open.empty()) {
+        switch (open.back().word) {
+            case ControlWord::IF: return "'if' without 'then'";
+            case ControlWord::TIMES: return "'times' without 'loop'";
+            default: return "'begin' without 'repeat'";
+        }
+    }
+    return {};
+}
+
+std::string controlFlowError(const std::vector<std::string>& tokens) {
+    std::vector<size_t> targets;
+    return matchControlFlow(tokens.size(), [&](size_t i) { return std::string_view(tokens[i]); },
+                            targets);
+}
+
+// Resolves the control words to jumps.  If they do not nest, the body is left
+// as it is: they compile as unknown names, which report when they are run.
+static void resolveControlFlow(std::vector<Instruction>& code) {
+    std::vector<size_t> targets;
+    auto tokenAt = [&](size_t i) { return std::string_view(code[i].token); };
+    if (!matchControlFlow(code.size(), tokenAt, targets).empty()) return;
+    for (size_t i = 0; i < code.size(); ++i) {
+        switch (controlWord(code[i].token)) {
+            case ControlWord::NONE: continue;
+            case ControlWord::IF:
+            case ControlWord::WHILE: code[i].code = OpCode::BRANCH; break;
+            case ControlWord::TIMES: code[i].code = OpCode::TIMES; break;
+            case ControlWord::LOOP: code[i].code = OpCode::LOOP; break;
+            default: code[i].code = OpCode::JUMP; break;
+        }
+        code[i].target = targets[i];
+    }
+}
+
+// ============================================================================
+// COMPILATION
+// ============================================================================
+
+// Tokens handled by handleMeta/handleSpecial depend on recording and settings
+// state, so they are always re-dispatched through processToken
+static bool isDynamicToken(const std::string& token) {
+    if (token == "}" || token == "]") return true;
+    if (findBuiltin(token)) return false;  // e.g. "<=", not an assignment or array file
+    if (token.size() > 1 && token[0] == '<') return true;  // Array file, case-sensitive path
+    if (token.size() > 1) {
+        char last = token.back();
+        if (last == '=' || last == '[' || last == '{' || last == '@') return true;
+    }
+    return token == "sto" || token == "rcl" || token == "scale" || token == "fix" ||
+           token == "show" || token == "config" || token == "fmt" || token == "autobind" ||
+           token == "quiet" || token == "quietops" || token == "enter" || token == "prof";
+}
+
+void RPNCalculator::compileToken(Instruction& ins) {
+    const std::string& token = ins.token;
+    ins.code = OpCode::TOKEN;
+    if (token.empty() || isDynamicToken(token)) return;
+
+    // Inline numeric + operator (same precedence as processToken)
+    if (token.size() > 1) {
+        size_t opStart;
+        std::string_view op = extractOperator(token, opStart);
+        if (!op.empty() && opStart > 0) {
+            std::string_view numPart(token.data(), opStart);
+            double value;
+            NumberParse parsed = parseNumber(numPart, value);
+            if (parsed != NumberParse::INVALID) {
+                const Operator* opObj = registry_->getOperator(op);
+                // sto/rcl and out-of-range literals are handled at run time
+                if (!opObj || parsed == NumberParse::OUT_OF_RANGE) return;
+                ins.value = value;
+                ins.code = OpCode::INLINE;
+                ins.op = opObj;
+                ins.literal = std::string(numPart);
+                return;
+            }
+        }
+    }
+
+    switch (parseNumber(token, ins.value)) {
+        case NumberParse::OK:
+            ins.code = OpCode::PUSH;
+            return;
+        case NumberParse::OUT_OF_RANGE:
+            return;  // Reported at run time
+        case NumberParse::INVALID:
+            break;
+    }
+
+    if (const Operator* op = registry_->getOperator(token)) {
+        ins.code = op->scalar ? OpCode::APPLY : OpCode::CALL;
+        ins.op = op;
+        return;
+    }
+
+    // Temporary operators and variables can be defined after compilation,
+    // so the name is interned now and checked when executed
+    ins.code = OpCode::LOAD;
+    ins.symbol = SymbolTable::instance().intern(token);
+    ins.reg = registerIndex(token);
+    if (ins.reg >= 0) {
+        ins.code = OpCode::REGISTER;
+    }
+}
+
+const CompiledCode* RPNCalculator::compileProgram(Program& program) {
+    std::lock_guard<std::mutex> lock(program.buildMutex);
+    std::vector<Program::Build>& builds = program.builds;
+    builds.erase(std::remove_if(builds.begin(), builds.end(),
+                                [](const Program::Build& b) { return b.snapshot.expired(); }),
+                 builds.end());
+
+    // Another calculator on this snapshot may have built it already
+    const CompiledCode* published = nullptr;
+    for (const auto& b : builds) {
+        if (b.code->version == registry_->version()) published = b.code.get();
+    }
+    if (!published) {
+        auto build = std::make_unique<CompiledCode>();
+        build->code.reserve(program.tokens.size());
+        for (const auto& source : program.tokens) {
+            Instruction ins{OpCode::TOKEN, 0.0, nullptr, kNoSymbol, -1, 0, source, ""};
+            std::transform(ins.token.begin(), ins.token.end(), ins.token.begin(), ::tolower);
+            compileToken(ins);
+            build->code.push_back(std::move(ins));
+        }
+        resolveControlFlow(build->code);
+        build->version = registry_->version();
+        published = build.get();
+        builds.push_back({std::move(build), registry_});
+    }
+    program.publish(published);
+    return published;
+}
+
+void RPNCalculator::compileUserOperators() {
+    for (const auto& name : registry_->getNamesByCategory(OperatorCategory::USER)) {
+        const Operator* op = registry_->getOperator(name);
+        if (op && op->program && !op->program->latest(registry_->version())) {
+            compileProgram(*op->program);
+        }
+    }
+}
+
+// ============================================================================
+// EXECUTION
+// ============================================================================
+
+// What the operator's execute does, with its arithmetic the only call left
+inline void RPNCalculator::applyScalar(const Operator& op) {
+    double x = stack_.pop();
+    double y = op.type == OperatorType::BINARY ? stack_.pop() : 0.0;
+    lastX_ = x;
+    double result = op.scalar(*this, y, x);
+    stack_.push(result);
+    print(result);
+    stackLiftEnabled_ = true;
+}
+
+const CompiledCode* RPNCalculator::currentBuild(Program& program) {
+    const CompiledCode* code = program.latest(registry_->version());
+    return code ? code : compileProgram(program);
+}
+
+// ============================================================================
+// CALL STACK
+// ============================================================================
+
+void RPNCalculator::enterCall(Program& program, CallKind kind, std::string_view token,
+                              SymbolId profileId) {
+    // Tail call: an operator whose body has nothing left after this call
+    // (but jumps, as in "... if ... f then") is replaced by the callee, so
+    // tail recursion runs in constant space.  Profiled calls keep their
+    // activations, so each one is timed.
+    if (runningCalls_ && kind == CallKind::OPERATOR && profileId == kNoSymbol) {
+        if (interruptCalls()) return;
+        Activation& caller = calls_.back();
+        const std::vector<Instruction>& rest = caller.code->code;
+        size_t next = caller.ip;
+        while (next < rest.size() && rest[next].code == OpCode::JUMP) {
+            next = rest[next].target;  // Every loop back to "begin" passes a "while"
+        }
+        if (caller.kind == CallKind::OPERATOR && caller.profileId == kNoSymbol &&
+            next == rest.size()) {
+            // Bound as if nested, so unbound registers still see the caller's
+            Frame frame = autobindXYZ_ ? bindFrame() : Frame{};
+            frames_.resize(caller.frameDepth);
+            loopCounts_.resize(caller.loopDepth);
+            if (autobindXYZ_) {
+                frames_.push_back(frame);
+            }
+            caller.program = &program;
+            caller.code = currentBuild(program);
+            caller.ip = 0;
+            return;
+        }
+    }
+
+    size_t frameBytes = (frames_.size() + (kind != CallKind::BODY)) * sizeof(Frame);
+    size_t loopBytes = loopCounts_.size() * sizeof(loopCounts_[0]);
+    if ((calls_.size() + 1) * sizeof(Activation) + frameBytes + loopBytes > callStackBudget_) {
+        printError("Error: Call stack exceeds " + std::to_string(callStackBudget_ >> 20) +
+                   " MB (callstack in ~/.rpn)");
+        if (profileId != kNoSymbol) {
+            endProfile(profileId);
+        }
+        if (kind == CallKind::MACRO) {
+            runningMacros_.pop_back();
+        }
+        abandonCalls();
+        return;
+    }
+
+    // Auto-bind x, y, z, t to top 4 stack positions (non-destructive peek) if enabled.
+    // Truncating back to the entry depth on return also drops anything the body left behind.
+    size_t frameDepth = frames_.size();
+    if (kind != CallKind::BODY) {
+        if (quietOperators_ && callDepth_ == 0 && macroDepth_ == 0) {
+            callToken_ = token;
+        }
+        if (kind == CallKind::OPERATOR) {
+            callDepth_++;
+        } else {
+            macroDepth_++;
+        }
+        if (autobindXYZ_) {
+            pushFrame();
+        }
+    }
+    calls_.push_back({&program, currentBuild(program), 0, frameDepth, loopCounts_.size(), profileId,
+                      kind});
+    if (!runningCalls_) {
+        runCalls();
+    }
+}
+
+void RPNCalculator::returnFromCall() {
+    Activation& done = calls_.back();
+    CallKind kind = done.kind;
+    SymbolId profileId = done.profileId;
+    if (kind != CallKind::BODY) {
+        frames_.resize(done.frameDepth);
+    }
+    loopCounts_.resize(done.loopDepth);  // Loops the budget error abandoned
+    calls_.pop_back();
+
+    if (kind == CallKind::OPERATOR) {
+        callDepth_--;
+    } else if (kind == CallKind::MACRO) {
+        macroDepth_--;
+        runningMacros_.pop_back();
+    }
+    if (kind != CallKind::BODY && quietOperators_ && callDepth_ == 0 && macroDepth_ == 0 &&
+        !quiet_) {
+        currentToken_ = callToken_;
+        printResult();
+    }
+    if (profileId != kNoSymbol) {
+        endProfile(profileId);
+    }
+}
+
+// Abandon the whole call chain; each activation still returns normally
+void RPNCalculator::abandonCalls() {
+    for (Activation& call : calls_) {
+        call.ip = call.program->tokens.size();
+    }
+}
+
+volatile std::sig_atomic_t RPNCalculator::interrupted_ = 0;
+
+bool RPNCalculator::interruptCalls() {
+    if (!interrupted_) return false;
+    interrupted_ = 0;
+    printError("Error: Interrupted");
+    abandonCalls();
+    return true;
+}
+
+void RPNCalculator::runCalls() {
+    runningCalls_ = true;
+    while (!calls_.empty()) {
+        Activation& call = calls_.back();
+        const CompiledCode& code = *call.code;
+        const size_t count = code.code.size();
+        size_t ip = call.ip;
+        for (;;) {
+            if (ip == count) {
+                returnFromCall();
+                break;
+            }
+            if (registry_->version() != code.version) {
+                // The body changed the registry; continue in a build against
+                // the new one, which has the same instruction indices
+                call.ip = ip;
+                call.code = currentBuild(*call.program);
+                break;
+            }
+
+            const Instruction& ins = code.code[ip++];
+            switch (ins.code) {
+                case OpCode::PUSH:
+                    currentToken_ = ins.token;
+                    stack_.push(ins.value);
+                    print(ins.value);
+                    stackLiftEnabled_ = true;
+                    continue;
+
+                case OpCode::APPLY:  // Built-in, so no activation changes
+                    currentToken_ = ins.token;
+                    if (liveArrays_ || profiling_) {
+                        callOperator(*ins.op);
+                    } else {
+                        applyScalar(*ins.op);
+                    }
+                    continue;
+
+                case OpCode::JUMP:
+                    if (ins.target < ip && interruptCalls()) {
+                        ip = count;
+                        continue;
+                    }
+                    ip = ins.target;
+                    continue;
+
+                case OpCode::BRANCH: {
+                    double condition = stack_.pop();
+                    if (isArrayHandle(condition)) {
+                        printError("Error: '" + ins.token + "' needs a number, not an array");
+                        condition = 0.0;
+                    }
+                    if (condition == 0.0) {
+                        ip = ins.target;
+                    }
+                    continue;
+                }
+
+                case OpCode::TIMES: {
+                    double count = stack_.pop();
+                    if (isArrayHandle(count)) {
+                        printError("Error: 'times' needs a number, not an array");
+                        count = 0.0;
+                    }
+                    if (std::isfinite(count) ? std::floor(count) > kMaxLoopCount : count > 0.0) {
+                        printError("Error: Loop count too large");
+                        count = 0.0;
+                    }
+                    if (count >= 1.0) {
+                        loopCounts_.push_back(static_cast<std::uint64_t>(count));
+                    } else {
+                        ip = ins.target;  // Also NaN
+                    }
+                    continue;
+                }
+
+                case OpCode::LOOP:
+                    if (interruptCalls()) {
+                        ip = count;
+                    } else if (--loopCounts_.back() > 0) {
+                        ip = ins.target;
+                    } else {
+                        loopCounts_.pop_back();
+                    }
+                    continue;
+
+                default:
+                    break;
+            }
+
+            // The rest may push or pop activations, after which call is stale
+            call.ip = ip;
+            switch (ins.code) {
+                case OpCode::CALL:
+                    currentToken_ = ins.token;
+                    if (liveArrays_ || profiling_) {
+                        callOperator(*ins.op);
+                    } else {
+                        ins.op->execute(*this, *ins.op);
+                    }
+                    break;
+
+                case OpCode::INLINE:
+                    stack_.push(ins.value);
+                    currentToken_ = ins.literal;  // Show as plain number (no $op annotation)
+                    print(ins.value);
+                    currentToken_ = ins.op->name;
+                    if (liveArrays_ || profiling_) {
+                        callOperator(*ins.op);
+                    } else if (ins.op->scalar) {
+                        applyScalar(*ins.op);
+                    } else {
+                        ins.op->execute(*this, *ins.op);
+                    }
+                    currentToken_.clear();
+                    break;
+
+                case OpCode::LOAD:
+                    currentToken_ = ins.token;
+                    if (const auto* macro = namedMacroCount_ ? findMacro(ins.symbol) : nullptr) {
+                        playMacro(*macro, ins.token);
+                    } else if (const double* value = findVariable(ins.symbol)) {
+                        stack_.push(*value);
+                        print(*value);
+                    } else {
+                        processToken(ins.token);  // Reports unknown input
+                    }
+                    break;
+
+                case OpCode::REGISTER: {
+                    currentToken_ = ins.token;
+                    const double* value = autobindXYZ_ ? findRegister(ins.reg) : nullptr;
+                    if (!value) {
+                        value = findVariable(ins.symbol);
+                    }
+                    if (const auto* macro = namedMacroCount_ ? findMacro(ins.symbol) : nullptr) {
+                        playMacro(*macro, ins.token);
+                    } else if (value) {
+                        stack_.push(*value);
+                        print(*value);
+                    } else {
+                        // Unbound: positional stack reference or unknown input
+                        processToken(ins.token);
+                    }
+                    break;
+                }
+
+                case OpCode::TOKEN:
+                    processToken(call.program->tokens[ip - 1]);
+                    break;
+
+                default:
+                    break;  // Handled above
+            }
+            break;
+        }
+    }
+    runningCalls_ = false;
+}
+
+void RPNCalculator::runProgram(Program& program) {
+    enterCall(program, CallKind::BODY, {});
+}
+
+void RPNCalculator::callUserOperator(Program& program, SymbolId profileId) {
+    enterCall(program, CallKind::OPERATOR, currentToken_, profileId);
+}
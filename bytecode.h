@@ -0,0 +1,123 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "symbols.h"
+
+// Forward declarations
+class RPNCalculator;
+class RegistrySnapshot;
+struct Operator;
+
+// Instruction kinds for compiled user-defined operator bodies
+enum class OpCode : std::uint8_t {
+    PUSH,       // Push a pre-parsed literal
+    CALL,       // Execute a resolved registry operator
+    APPLY,      // Apply a resolved operator's arithmetic to the stack (Operator::scalar)
+    INLINE,     // Push a literal, then execute a resolved operator (e.g., "5+")
+    LOAD,       // Temporary operator or variable slot
+    REGISTER,   // x/y/z/t: auto-bound frame register, else variable slot
+    TOKEN,      // Anything else: re-dispatch the source token through processToken
+    JUMP,       // Continue at target (else, then, begin, repeat)
+    BRANCH,     // Pop a condition and continue at target if it is zero (if, while)
+    TIMES,      // Pop a count and enter a counted loop, or continue at target if it is < 1
+    LOOP        // Count down the innermost counted loop; continue at target while any remain
+};
+
+// Structured control flow in operator bodies:
+//     cond if ... [else ...] then
+//     n times ... loop
+//     begin ... cond while ... repeat
+// The words are matched when a body is compiled, so they only run there
+enum class ControlWord : std::uint8_t { NONE, IF, ELSE, THEN, TIMES, LOOP, BEGIN, WHILE, REPEAT };
+ControlWord controlWord(std::string_view token);  // Lowercase token
+bool opensControl(ControlWord word);   // if, times, begin
+bool closesControl(ControlWord word);  // then, loop, repeat
+
+// Why a body's control words do not nest properly, or empty if they do
+std::string controlFlowError(const std::vector<std::string>& tokens);
+
+// One instruction per source token, so the instruction index is also the token index
+struct Instruction {
+    OpCode code;
+    double value;           // PUSH/INLINE literal
+    const Operator* op;     // CALL/APPLY/INLINE target
+    SymbolId symbol;        // LOAD/REGISTER temporary operator or variable
+    int reg;                // REGISTER index (x=0, y=1, z=2, t=3)
+    size_t target;          // JUMP/BRANCH/TIMES/LOOP destination
+    std::string token;      // Lowercased source token (output annotation and fallback)
+    std::string literal;    // INLINE numeric part (output annotation)
+};
+
+// Instructions resolved against one registry snapshot; immutable once built
+struct CompiledCode {
+    std::vector<Instruction> code;
+    std::uint64_t version;  // Registry snapshot version
+};
+
+// Body of a user-defined operator.  Operator pointers are only valid for the
+// registry snapshot the code was compiled against, so the VM recompiles on
+// entry when the calculator's snapshot has moved on.  Programs are shared by
+// every calculator (and thread).  A calculator only runs builds for a
+// snapshot it holds, so each build is kept while its snapshot is alive and
+// freed by a later compile once nothing holds the snapshot.
+struct Program {
+    std::vector<std::string> tokens;    // Source tokens as defined (saved to ~/.rpn)
+
+    // Latest build if it was compiled against version, else null.  Lock-free:
+    // the pointer and its version are read together under a sequence count,
+    // so a build is only dereferenced by a caller holding its snapshot.
+    const CompiledCode* latest(std::uint64_t version) const {
+        unsigned seq = seq_.load(std::memory_order_acquire);
+        if (seq & 1) return nullptr;  // Being published; compile takes the lock
+        const CompiledCode* code = compiled_.load(std::memory_order_relaxed);
+        std::uint64_t codeVersion = version_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) != seq || codeVersion != version) return nullptr;
+        return code;
+    }
+    void publish(const CompiledCode* code) {  // With buildMutex held
+        unsigned seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        compiled_.store(code, std::memory_order_relaxed);
+        version_.store(code->version, std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    struct Build {
+        std::unique_ptr<const CompiledCode> code;
+        std::weak_ptr<const RegistrySnapshot> snapshot;  // Compiled against
+    };
+    std::mutex buildMutex;
+    std::vector<Build> builds;  // One per live snapshot the body was compiled against
+
+private:
+    std::atomic<unsigned> seq_{0};  // Odd while publishing
+    std::atomic<const CompiledCode*> compiled_{nullptr};
+    std::atomic<std::uint64_t> version_{0};  // Snapshot versions start at 1
+};
+
+#endif // BYTECODE_H
@@ -0,0 +1,727 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "rpn.h"
+#include "mappedfile.h"
+#include "operators.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// CONFIGURATION RECORDS
+// ============================================================================
+
+// loadConfig parses the config text into a flat list of records, each a
+// ConfigRecord tag and its fields, and applies them in order.  The records
+// are also what the binary cache stores, so a cached start skips the text
+// parsing entirely and replays the same sequence.
+namespace {
+
+enum class ConfigRecord : std::uint8_t {
+    ANGLE,      // u8: 0 radians, 1 degrees, 2 gradians
+    SCALE,      // i32
+    MEMORY,     // i32 location, f64 value
+    FORMAT,     // u8 on/off
+    AUTOBIND,   // u8 on/off
+    QUIET,      // u8 on/off
+    QUIET_OPS,  // u8 on/off
+    VARIABLE,   // name, f64 value
+    OPERATOR,   // name, description, tokens
+    DELETE,     // name
+    PREFIX,     // string
+    MACRO,      // name, tokens
+    CALL_STACK  // u32 megabytes
+};
+
+struct ConfigCounts {
+    size_t operatorLines = 0;  // "operator" and "delete" lines
+    size_t liveOperators = 0;  // Names still defined at the end
+};
+
+// Fields are native-endian; strings are a u32 length and the bytes, token
+// lists a u32 count and the strings
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+void put(std::string& out, const std::string& text) {
+    put(out, static_cast<std::uint32_t>(text.size()));
+    out += text;
+}
+
+void put(std::string& out, const std::vector<std::string>& tokens) {
+    put(out, static_cast<std::uint32_t>(tokens.size()));
+    for (const auto& token : tokens) put(out, token);
+}
+
+template <typename Tag, typename T>
+void put(std::string& out, Tag tag, const T& value) {
+    put(out, tag);
+    put(out, value);
+}
+
+// Reads fields back; a truncated record ends the list
+class RecordReader {
+public:
+    explicit RecordReader(std::string_view data) : data_(data) {}
+
+    bool done() const { return pos_ >= data_.size(); }
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (data_.size() - pos_ < sizeof value) {
+            pos_ = data_.size();
+            return value;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof value);
+        pos_ += sizeof value;
+        return value;
+    }
+
+    std::string getString() {
+        std::uint32_t size = get<std::uint32_t>();
+        size = static_cast<std::uint32_t>(std::min<size_t>(size, data_.size() - pos_));
+        std::string text(data_.data() + pos_, size);
+        pos_ += size;
+        return text;
+    }
+
+    std::vector<std::string> getTokens() {
+        std::uint32_t count = get<std::uint32_t>();
+        std::vector<std::string> tokens;
+        while (count-- > 0 && !done()) tokens.push_back(getString());
+        return tokens;
+    }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+// Word-at-a-time hash, to tell whether a cache was built from this text
+std::uint64_t hashBytes(std::string_view data) {
+    const std::uint64_t kPrime = 0x100000001b3ull;
+    std::uint64_t hash = 0xcbf29ce484222325ull ^ data.size();
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof word);
+        hash = (hash ^ word) * kPrime;
+        hash ^= hash >> 29;
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data.data() + i, data.size() - i);
+    hash = (hash ^ tail) * kPrime;
+    return hash ^ (hash >> 32);
+}
+
+// ============================================================================
+// BINARY CONFIG CACHE
+// ============================================================================
+//
+// <config>.cache holds a CacheHeader followed by the config's records.  It
+// is valid while the config's size, mtime and content hash match the header
+// and the record bytes match theirs; otherwise it is rebuilt from the text.
+
+const char kCacheMagic[8] = {'r', 'p', 'n', 'c', 'a', 'c', 'h', 'e'};
+const std::uint32_t kCacheVersion = 2;  // Bump when records or the header change
+
+struct CacheHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t operatorLines;   // Journal statistics for compaction
+    std::uint32_t liveOperators;
+    std::uint32_t reserved;
+    std::uint64_t configSize;
+    std::int64_t configMtimeSec;
+    std::int64_t configMtimeNsec;
+    std::uint64_t configHash;
+    std::uint64_t recordsSize;
+    std::uint64_t recordsHash;
+};
+
+// Read-only mapping of a cache file
+class MappedCache {
+public:
+    explicit MappedCache(const std::string& path) : file_(path.c_str()) {}
+
+    // The records, if the cache was built from this config text
+    bool match(const struct stat& config, std::uint64_t configHash, CacheHeader& header,
+               std::string_view& records) const {
+        std::string_view data = file_.text();
+        if (data.size() < sizeof header) return false;
+        std::memcpy(&header, data.data(), sizeof header);
+        if (std::memcmp(header.magic, kCacheMagic, sizeof kCacheMagic) != 0 ||
+            header.version != kCacheVersion ||
+            header.configSize != static_cast<std::uint64_t>(config.st_size) ||
+            header.configMtimeSec != config.st_mtim.tv_sec ||
+            header.configMtimeNsec != config.st_mtim.tv_nsec ||
+            header.configHash != configHash ||
+            header.recordsSize != data.size() - sizeof header) {
+            return false;
+        }
+        records = data.substr(sizeof header);
+        return hashBytes(records) == header.recordsHash;
+    }
+
+private:
+    MappedFile file_;
+};
+
+// Replace the cache by rename, so readers never see a partial file.  A
+// config directory that is not writable just means no cache.
+void writeCache(const std::string& path, CacheHeader header, std::string_view records) {
+    std::memcpy(header.magic, kCacheMagic, sizeof kCacheMagic);
+    header.version = kCacheVersion;
+    header.reserved = 0;
+    header.recordsSize = records.size();
+    header.recordsHash = hashBytes(records);
+
+    std::string tempPath = path + ".tmp" + std::to_string(::getpid());
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return;
+    std::string data(reinterpret_cast<const char*>(&header), sizeof header);
+    data.append(records.data(), records.size());
+    bool written = ::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    ::close(fd);
+    if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+    }
+}
+
+// ============================================================================
+// CONFIGURATION PARSING
+// ============================================================================
+
+// Text to records, counting operator lines for journal compaction
+void parseConfig(std::string_view text, std::string& records, ConfigCounts& counts) {
+    std::istringstream configFile{std::string(text)};
+    std::unordered_set<std::string> liveOperators;
+    std::string line;
+    while (std::getline(configFile, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        
+        std::istringstream iss(line);
+        std::string cmd;
+        iss >> cmd;
+        
+        if (cmd == "deg") {
+            put(records, ConfigRecord::ANGLE, std::uint8_t{1});
+        } else if (cmd == "rad") {
+            put(records, ConfigRecord::ANGLE, std::uint8_t{0});
+        } else if (cmd == "grd") {
+            put(records, ConfigRecord::ANGLE, std::uint8_t{2});
+        } else if (cmd == "scale" || cmd == "fix") {
+            int s;
+            if (iss >> s && s >= 0 && s <= 15) {
+                put(records, ConfigRecord::SCALE, static_cast<std::int32_t>(s));
+            }
+        } else if (cmd == "callstack") {
+            // callstack <megabytes> - memory budget for nested operator calls
+            int mb;
+            if (iss >> mb && mb >= 1 && mb <= 1024 * 1024) {
+                put(records, ConfigRecord::CALL_STACK, static_cast<std::uint32_t>(mb));
+            }
+        } else if (cmd == "mem") {
+            int loc;
+            double val;
+            if (iss >> loc >> val) {
+                put(records, ConfigRecord::MEMORY, static_cast<std::int32_t>(loc));
+                put(records, val);
+            }
+        } else if (cmd == "fmt") {
+            std::string value;
+            if (iss >> value) {
+                if (value == "off" || value == "0" || value == "false") {
+                    put(records, ConfigRecord::FORMAT, std::uint8_t{0});
+                } else if (value == "on" || value == "1" || value == "true") {
+                    put(records, ConfigRecord::FORMAT, std::uint8_t{1});
+                }
+            }
+        } else if (cmd == "autobind") {
+            std::string value;
+            if (iss >> value) {
+                if (value == "off" || value == "0" || value == "false") {
+                    put(records, ConfigRecord::AUTOBIND, std::uint8_t{0});
+                } else if (value == "on" || value == "1" || value == "true") {
+                    put(records, ConfigRecord::AUTOBIND, std::uint8_t{1});
+                }
+            }
+        } else if (cmd == "quiet" || cmd == "quietops") {
+            std::string value;
+            if (iss >> value) {
+                bool enabled = (value == "on" || value == "1" || value == "true");
+                bool disabled = (value == "off" || value == "0" || value == "false");
+                if (enabled || disabled) {
+                    put(records, cmd == "quietops" ? ConfigRecord::QUIET_OPS : ConfigRecord::QUIET,
+                        static_cast<std::uint8_t>(enabled));
+                }
+            }
+        } else if (cmd == "var") {
+            // var <name> <value>
+            std::string name;
+            double val;
+            if (iss >> name >> val) {
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                put(records, ConfigRecord::VARIABLE, name);
+                put(records, val);
+            }
+        } else if (cmd == "operator") {
+            // operator <name> <description words...> : <tokens...>
+            std::string name;
+            if (iss >> name) {
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                // Read the rest of the line to split on ':'
+                std::string rest;
+                std::getline(iss, rest);
+                size_t colonPos = rest.find(':');
+                std::string description = "User-defined";
+                std::vector<std::string> tokens;
+                if (colonPos != std::string::npos) {
+                    // Description is before ':', tokens after
+                    std::string descPart = rest.substr(0, colonPos);
+                    // Trim whitespace from description
+                    size_t start = descPart.find_first_not_of(" \t");
+                    size_t end = descPart.find_last_not_of(" \t");
+                    if (start != std::string::npos) {
+                        description = descPart.substr(start, end - start + 1);
+                    }
+                    std::string tokenPart = rest.substr(colonPos + 1);
+                    std::istringstream tiss(tokenPart);
+                    std::string tok;
+                    while (tiss >> tok) {
+                        tokens.push_back(tok);
+                    }
+                } else {
+                    // No colon — everything is tokens, use default description
+                    std::istringstream tiss(rest);
+                    std::string tok;
+                    while (tiss >> tok) {
+                        tokens.push_back(tok);
+                    }
+                }
+                if (!tokens.empty()) {
+                    put(records, ConfigRecord::OPERATOR, name);
+                    put(records, description);
+                    put(records, tokens);
+                }
+                counts.operatorLines++;
+                liveOperators.insert(name);
+            }
+        } else if (cmd == "delete") {
+            // delete <name> - tombstone appended by deleting an operator
+            std::string name;
+            if (iss >> name) {
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                put(records, ConfigRecord::DELETE, name);
+                counts.operatorLines++;
+                liveOperators.erase(name);
+            }
+        } else if (cmd == "prefix") {
+            // prefix "<string>" - Set output prefix (quoted string)
+            // Read the rest of the line and extract quoted string
+            std::string rest;
+            std::getline(iss, rest);
+            // Trim leading whitespace
+            size_t start = rest.find_first_not_of(" \t");
+            if (start != std::string::npos) {
+                rest = rest.substr(start);
+                // Check for quotes
+                if (!rest.empty() && rest[0] == '"') {
+                    // Find closing quote
+                    size_t endQuote = rest.find('"', 1);
+                    if (endQuote != std::string::npos) {
+                        // Extract string between quotes, handling escape sequences
+                        std::string quoted = rest.substr(1, endQuote - 1);
+                        /* Process escape sequences: \t \n \\ \" */
+                        std::string processed;
+                        for (size_t i = 0; i < quoted.length(); ++i) {
+                            if (quoted[i] == '\\' && i + 1 < quoted.length()) {
+                                char next = quoted[i + 1];
+                                if (next == 't') {
+                                    processed += '\t';
+                                    ++i;
+                                } else if (next == 'n') {
+                                    processed += '\n';
+                                    ++i;
+                                } else if (next == '\\') {
+                                    processed += '\\';
+                                    ++i;
+                                } else if (next == '"') {
+                                    processed += '"';
+                                    ++i;
+                                } else {
+                                    processed += quoted[i];
+                                }
+                            } else {
+                                processed += quoted[i];
+                            }
+                        }
+                        put(records, ConfigRecord::PREFIX, processed);
+                    }
+                } else {
+                    // No quotes - use rest of line as-is for backward compatibility
+                    put(records, ConfigRecord::PREFIX, rest);
+                }
+            } else {
+                put(records, ConfigRecord::PREFIX, std::string());  // Empty prefix
+            }
+        } else if (cmd == "macro") {
+            // macro <name> <tokens...> (deprecated keyword, use name[ ] syntax instead)
+            std::string name;
+            if (iss >> name) {
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                std::vector<std::string> tokens;
+                std::string token;
+                while (iss >> token) {
+                    tokens.push_back(token);
+                }
+                if (!tokens.empty()) {
+                    put(records, ConfigRecord::MACRO, name);
+                    put(records, tokens);
+                }
+            }
+        }
+    }
+    counts.liveOperators = liveOperators.size();
+}
+
+}  // namespace
+
+// ============================================================================
+// OPERATOR JOURNAL
+// ============================================================================
+
+// ~/.rpn doubles as a journal of operator definitions: saving appends an
+// "operator" line and deleting appends a "delete" tombstone, so each costs
+// one small write however large the file is.  Later lines override earlier
+// ones when the file is replayed, and loadConfig compacts it once
+// superseded lines outnumber live definitions.
+//
+// Writers hold an exclusive flock.  Compaction replaces the file by rename,
+// so a writer that locked the old inode reopens the path and tries again.
+static int lockConfig(const std::string& path, int flags) {
+    for (;;) {
+        int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd < 0) return -1;
+        struct stat opened, current;
+        if (::flock(fd, LOCK_EX) != 0 || ::fstat(fd, &opened) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        if (::stat(path.c_str(), &current) == 0 &&
+            opened.st_dev == current.st_dev && opened.st_ino == current.st_ino) {
+            return fd;
+        }
+        ::close(fd);  // Replaced while waiting for the lock
+    }
+}
+
+static void appendConfigLine(const std::string& line) {
+    const char* home = getenv("HOME");
+    if (!home) return;
+    int fd = lockConfig(std::string(home) + "/.rpn", O_WRONLY | O_APPEND | O_CREAT);
+    if (fd < 0) return;
+    std::string text = line + "\n";
+    if (::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size())) {
+        ::fsync(fd);
+    }
+    ::close(fd);  // Releases the lock
+}
+
+// Rewrite the config keeping only the last definition of each live operator
+static void compactConfig(const std::string& path) {
+    int fd = lockConfig(path, O_RDONLY);
+    if (fd < 0) return;
+
+    // Re-read under the lock: other processes may have appended since
+    std::string text;
+    char block[64 * 1024];
+    ssize_t n;
+    while ((n = ::read(fd, block, sizeof block)) > 0) {
+        text.append(block, n);
+    }
+    std::vector<std::string_view> lines;
+    std::unordered_map<std::string, size_t> lastDefinition;  // Lowercase name -> index in lines
+    size_t pos = 0;
+    while (n == 0 && pos < text.size()) {
+        size_t nl = std::min(text.find('\n', pos), text.size());
+        std::string_view line(text.data() + pos, nl - pos);
+        pos = nl + 1;
+
+        size_t cmdStart = line.find_first_not_of(" \t");
+        size_t cmdEnd = std::min(line.find_first_of(" \t", cmdStart), line.size());
+        std::string_view cmd = cmdStart == std::string_view::npos
+            ? std::string_view() : line.substr(cmdStart, cmdEnd - cmdStart);
+        if (cmd == "operator" || cmd == "delete") {
+            size_t nameStart = line.find_first_not_of(" \t", cmdEnd);
+            size_t nameEnd = std::min(line.find_first_of(" \t", nameStart), line.size());
+            if (nameStart == std::string_view::npos) {
+                lines.push_back(line);  // No name: parseConfig ignores it too
+                continue;
+            }
+            // Names are case-folded as parseConfig does, so "delete foo" ends "operator Foo"
+            std::string name(line.substr(nameStart, nameEnd - nameStart));
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            auto previous = lastDefinition.find(name);
+            if (previous != lastDefinition.end()) {
+                lines[previous->second] = std::string_view();  // Superseded
+                lastDefinition.erase(previous);
+            }
+            if (cmd == "delete") continue;
+            lastDefinition[std::move(name)] = lines.size();
+        }
+        lines.push_back(line);
+    }
+
+    std::string tempPath = path + ".tmp";
+    std::ofstream outFile(tempPath);
+    if (n == 0 && outFile.is_open()) {
+        for (const auto& line : lines) {
+            if (line.data()) outFile << line << "\n";
+        }
+        outFile.close();
+        int tempFd = ::open(tempPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (outFile && tempFd >= 0 && ::fsync(tempFd) == 0) {
+            std::rename(tempPath.c_str(), path.c_str());
+        }
+        if (tempFd >= 0) ::close(tempFd);
+    }
+    ::close(fd);
+}
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+void RPNCalculator::applyConfig(std::string_view records) {
+    RecordReader reader(records);
+    while (!reader.done()) {
+        switch (reader.get<ConfigRecord>()) {
+            case ConfigRecord::ANGLE: {
+                static const AngleMode kModes[] = {AngleMode::RADIANS, AngleMode::DEGREES,
+                                                   AngleMode::GRADIANS};
+                angleMode_ = kModes[std::min<unsigned>(reader.get<std::uint8_t>(), 2)];
+                break;
+            }
+            case ConfigRecord::SCALE:
+                scale_ = reader.get<std::int32_t>();
+                break;
+            case ConfigRecord::CALL_STACK:
+                callStackBudget_ = static_cast<size_t>(reader.get<std::uint32_t>()) << 20;
+                break;
+            case ConfigRecord::MEMORY: {
+                int location = reader.get<std::int32_t>();
+                memory_[location] = reader.get<double>();
+                break;
+            }
+            case ConfigRecord::FORMAT:
+                localeFormatting_ = reader.get<std::uint8_t>();
+                break;
+            case ConfigRecord::AUTOBIND:
+                autobindXYZ_ = reader.get<std::uint8_t>();
+                break;
+            case ConfigRecord::QUIET: {
+                bool enabled = reader.get<std::uint8_t>();
+                if (!quietPinned_) quiet_ = enabled;
+                break;
+            }
+            case ConfigRecord::QUIET_OPS:
+                quietOperators_ = reader.get<std::uint8_t>();
+                break;
+            case ConfigRecord::VARIABLE: {
+                std::string name = reader.getString();
+                // Silently ignore if it would shadow an operator
+                storeVariable(name, reader.get<double>());
+                break;
+            }
+            case ConfigRecord::OPERATOR: {
+                std::string name = reader.getString();
+                std::string description = reader.getString();
+                registerUserOperator(name, description, reader.getTokens());
+                break;
+            }
+            case ConfigRecord::DELETE: {
+                std::string name = reader.getString();
+                const Operator* existing = registry_->getOperator(name);
+                if (!existing || existing->category == OperatorCategory::USER) {
+                    OperatorRegistry::instance().removeOperator(name);
+                }
+                break;
+            }
+            case ConfigRecord::PREFIX:
+                outputPrefix_ = reader.getString();
+                break;
+            case ConfigRecord::MACRO: {
+                std::string name = reader.getString();
+                defineMacro(name, reader.getTokens());
+                break;
+            }
+            default:
+                return;  // Unknown tag: the rest cannot be decoded
+        }
+    }
+}
+
+RPNCalculator::ConfigStamp RPNCalculator::stampOf(const std::string& path, const struct stat& st) {
+    ConfigStamp stamp;
+    stamp.path = path;
+    stamp.device = st.st_dev;
+    stamp.inode = st.st_ino;
+    stamp.size = st.st_size;
+    stamp.mtimeSec = st.st_mtim.tv_sec;
+    stamp.mtimeNsec = st.st_mtim.tv_nsec;
+    return stamp;
+}
+
+void RPNCalculator::loadConfig() {
+    configStamp_ = ConfigStamp();
+
+    // Try local .rpn first, then fall back to ~/.rpn
+    const char* home = getenv("HOME");
+    std::string homePath = home ? std::string(home) + "/.rpn" : "";
+    std::string configPath = ".rpn";
+    int fd = ::open(configPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (!home) return;
+        configPath = homePath;
+        fd = ::open(configPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+    }
+    struct stat config;
+    std::string text;
+    bool readOk = ::fstat(fd, &config) == 0;
+    if (readOk) {
+        configStamp_ = stampOf(configPath, config);
+    }
+    char block[64 * 1024];
+    ssize_t n = 0;
+    while (readOk && (n = ::read(fd, block, sizeof block)) > 0) {
+        text.append(block, n);
+    }
+    ::close(fd);
+    if (!readOk || n < 0) return;
+
+    // ~/.rpn is where operator definitions are appended (possibly also ./.rpn)
+    struct stat journal;
+    bool isJournal = home && ::stat(homePath.c_str(), &journal) == 0 &&
+                     config.st_dev == journal.st_dev && config.st_ino == journal.st_ino;
+
+    // Use the cached records, or parse the text and cache them
+    std::string cachePath = configPath + ".cache";
+    std::uint64_t configHash = hashBytes(text);
+    MappedCache cache(cachePath);
+    CacheHeader header;
+    std::string_view records;
+    std::string parsed;
+    ConfigCounts counts;
+    if (cache.match(config, configHash, header, records)) {
+        counts.operatorLines = header.operatorLines;
+        counts.liveOperators = header.liveOperators;
+    } else {
+        parseConfig(text, parsed, counts);
+        records = parsed;
+        std::memset(&header, 0, sizeof header);
+        header.operatorLines = static_cast<std::uint32_t>(counts.operatorLines);
+        header.liveOperators = static_cast<std::uint32_t>(counts.liveOperators);
+        header.configSize = config.st_size;
+        header.configMtimeSec = config.st_mtim.tv_sec;
+        header.configMtimeNsec = config.st_mtim.tv_nsec;
+        header.configHash = configHash;
+        writeCache(cachePath, header, records);
+    }
+
+    // Publish the operators as one registry snapshot.  Bodies are compiled
+    // when first called, so a start only pays for the operators it uses.
+    std::optional<OperatorRegistry::Batch> batch(std::in_place, OperatorRegistry::instance());
+    deferCompile_ = true;
+    applyConfig(records);
+    batch.reset();
+    deferCompile_ = false;
+    repinRegistry();
+
+    // Compact the journal once most of its operator lines are dead
+    size_t deadLines = counts.operatorLines - counts.liveOperators;
+    if (isJournal && deadLines >= 64 && deadLines > counts.liveOperators) {
+        compactConfig(configPath);
+    }
+}
+
+// Whether loadConfig would now read a different file, or the same file changed
+bool RPNCalculator::configChanged() const {
+    const char* home = getenv("HOME");
+    struct stat st;
+    ConfigStamp now;
+    if (::stat(".rpn", &st) == 0) {
+        now = stampOf(".rpn", st);
+    } else if (home && ::stat((std::string(home) + "/.rpn").c_str(), &st) == 0) {
+        now = stampOf(std::string(home) + "/.rpn", st);
+    }
+    const ConfigStamp& was = configStamp_;
+    return now.path != was.path || now.device != was.device || now.inode != was.inode ||
+           now.size != was.size || now.mtimeSec != was.mtimeSec || now.mtimeNsec != was.mtimeNsec;
+}
+
+// Settings, variables and temporary operators come from the config alone, so
+// a fresh calculator loads it.  Every user-defined operator is replaced in the
+// same published snapshot, so one removed from the file disappears too.
+void RPNCalculator::reloadConfig() {
+    RPNCalculator fresh;
+    fresh.out_ = out_;
+    if (quietPinned_) fresh.setQuiet(true);
+    fresh.profiling_ = profiling_;
+    fresh.sharedRegistry_ = sharedRegistry_;
+    {
+        OperatorRegistry& registry = OperatorRegistry::instance();
+        OperatorRegistry::Batch batch(registry);
+        for (const auto& name : registry_->getNamesByCategory(OperatorCategory::USER)) {
+            registry.removeOperator(name);
+        }
+        fresh.loadConfig();
+    }
+    fresh.refreshRegistry();
+    fresh.compileUserOperators();
+    *this = std::move(fresh);
+}
+
+void RPNCalculator::saveUserOperator(const std::string& name, const std::string& description,
+                                      const std::vector<std::string>& tokens) {
+    // operator <name> <description> : <tokens...>
+    std::string opLine = "operator " + name + " " + description + " :";
+    for (const auto& t : tokens) {
+        opLine += " " + t;
+    }
+    appendConfigLine(opLine);
+}
+
+void RPNCalculator::deleteUserOperator(const std::string& name) {
+    appendConfigLine("delete " + name);
+}
+
@@ -0,0 +1,279 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "rpn.h"
+#include "array.h"
+#include "mappedfile.h"
+#include "operators.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+// ============================================================================
+// COLUMNAR CSV EVALUATION
+// ============================================================================
+
+namespace {
+
+const size_t kChunkRows = 4096;
+
+// Next record of text at or after pos, without its line ending (empty at the end)
+std::string_view nextRecord(std::string_view text, size_t& pos) {
+    size_t start = pos;
+    size_t nl = std::min(text.find('\n', start), text.size());
+    pos = std::min(nl + 1, text.size());
+    std::string_view record = text.substr(start, nl - start);
+    if (!record.empty() && record.back() == '\r') {
+        record.remove_suffix(1);
+    }
+    return record;
+}
+
+// Split a record on commas.  Quoted fields may contain commas; the view
+// excludes the quotes, and surrounding blanks are trimmed.
+void splitFields(std::string_view record, std::vector<std::string_view>& fields) {
+    fields.clear();
+    size_t pos = 0;
+    while (true) {
+        while (pos < record.size() && (record[pos] == ' ' || record[pos] == '\t')) pos++;
+        size_t start = pos, end;
+        if (pos < record.size() && record[pos] == '"') {
+            start = ++pos;
+            while (pos < record.size()) {
+                if (record[pos] == '"') {
+                    if (pos + 1 < record.size() && record[pos + 1] == '"') {
+                        pos += 2;  // Escaped quote
+                        continue;
+                    }
+                    break;
+                }
+                pos++;
+            }
+            end = pos;
+            pos = std::min(record.find(',', pos), record.size());
+        } else {
+            pos = std::min(record.find(',', pos), record.size());
+            end = pos;
+            while (end > start && (record[end - 1] == ' ' || record[end - 1] == '\t')) end--;
+        }
+        fields.push_back(record.substr(start, end - start));
+        if (pos >= record.size()) break;
+        pos++;
+    }
+}
+
+}  // namespace
+
+// Header names become variables, so the expression refers to columns by
+// name.  The expression is compiled once; when every instruction has an
+// element-wise kernel it runs over chunks of rows a column at a time,
+// otherwise (and for rows a kernel flags) row by row through the compiled
+// program.  Each input row is written back with the result appended;
+// anything else a row prints goes to stderr.
+void RPNCalculator::evaluateCsv(const char* path, const std::string& expr) {
+    loadConfig();
+    streaming_ = true;
+    quiet_ = true;
+    localeFormatting_ = false;  // Grouping separators would split the result column
+
+    if (expr.find_first_of(";{}[]") != std::string::npos) {
+        printError("Error: --expr takes a single expression (no ';' or definitions)");
+        return;
+    }
+    MappedFile file(path, MADV_SEQUENTIAL);
+    if (!file.ok()) {
+        printError("Error: Cannot read '" + std::string(path) + "': " + std::strerror(errno));
+        return;
+    }
+    std::string_view text = file.text();
+    size_t pos = 0;
+    std::string_view header = nextRecord(text, pos);
+    if (header.empty()) {
+        printError("Error: '" + std::string(path) + "' has no header row");
+        return;
+    }
+
+    // Bind the header names (first occurrence of a name wins)
+    std::vector<std::string_view> fields;
+    splitFields(header, fields);
+    std::vector<SymbolId> columnIds(fields.size(), kNoSymbol);
+    SymbolTable& symbols = SymbolTable::instance();
+    for (size_t c = 0; c < fields.size(); ++c) {
+        std::string name(fields[c]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (name.empty()) continue;
+        if (!storeVariable(name, 0.0)) {
+            printError("Error: Column '" + name + "' cannot be used as a variable name (shadows operator)");
+            continue;
+        }
+        SymbolId id = symbols.find(name);
+        if (std::find(columnIds.begin(), columnIds.end(), id) == columnIds.end()) {
+            columnIds[c] = id;
+        }
+    }
+
+    Program program;
+    size_t tpos = 0;
+    while ((tpos = expr.find_first_not_of(" \t\n\v\f\r", tpos)) != std::string::npos) {
+        size_t end = std::min(expr.find_first_of(" \t\n\v\f\r", tpos), expr.size());
+        program.tokens.push_back(expr.substr(tpos, end - tpos));
+        tpos = end;
+    }
+    const CompiledCode* compiled = compileProgram(program);
+    const std::vector<Instruction>& code = compiled->code;
+
+    // Columns the expression reads, and whether every instruction has a kernel
+    std::vector<size_t> usedColumns;    // Field index per used column
+    std::vector<SymbolId> usedIds;
+    std::vector<int> slot(code.size(), -1);  // Used column read by each LOAD/REGISTER
+    bool vectorizable = true;
+    for (size_t i = 0; i < code.size(); ++i) {
+        const Instruction& ins = code[i];
+        switch (ins.code) {
+            case OpCode::PUSH:
+                break;
+            case OpCode::CALL:
+            case OpCode::APPLY:
+            case OpCode::INLINE:
+                vectorizable = vectorizable && ins.op->kernel && ins.op->type != OperatorType::NULLARY;
+                break;
+            case OpCode::LOAD:
+            case OpCode::REGISTER: {
+                auto column = std::find(columnIds.begin(), columnIds.end(), ins.symbol);
+                if (column != columnIds.end()) {
+                    auto used = std::find(usedIds.begin(), usedIds.end(), ins.symbol);
+                    if (used == usedIds.end()) {
+                        usedIds.push_back(ins.symbol);
+                        usedColumns.push_back(column - columnIds.begin());
+                        used = usedIds.end() - 1;
+                    }
+                    slot[i] = static_cast<int>(used - usedIds.begin());
+                } else if (!findVariable(ins.symbol) || isArrayHandle(*findVariable(ins.symbol))) {
+                    vectorizable = false;  // Positional reference, unknown name or array
+                }
+                vectorizable = vectorizable && !findMacro(ins.symbol);
+                break;
+            }
+            case OpCode::TOKEN:
+            case OpCode::JUMP:
+            case OpCode::BRANCH:
+            case OpCode::TIMES:
+            case OpCode::LOOP:
+                vectorizable = false;  // Rows take different paths
+                break;
+        }
+    }
+
+    out_->write(header);
+    out_->write(",result\n");
+
+    std::vector<std::string_view> rows;
+    rows.reserve(kChunkRows);
+    std::vector<std::vector<double>> columns(usedIds.size(), std::vector<double>(kChunkRows));
+    std::vector<unsigned char> fallback(kChunkRows);  // Row needs the scalar path
+    std::vector<unsigned char> valid(kChunkRows);     // Every used field is a number
+    std::vector<std::vector<double>> scratch;          // One buffer per stack level
+    const std::vector<double> zeros(kChunkRows, 0.0);  // Popping an empty stack gives 0
+    std::vector<const double*> operands;
+    OutputSink* csvOut = out_;
+    ErrorSink diagnostics(*csvOut);  // Row programs print here, never into the CSV
+
+    while (pos < text.size()) {
+        // Gather and parse a chunk of rows
+        rows.clear();
+        while (rows.size() < kChunkRows && pos < text.size()) {
+            std::string_view record = nextRecord(text, pos);
+            if (!record.empty()) rows.push_back(record);
+        }
+        const size_t n = rows.size();
+        for (size_t r = 0; r < n; ++r) {
+            splitFields(rows[r], fields);
+            valid[r] = 1;
+            for (size_t u = 0; u < usedColumns.size(); ++u) {
+                size_t c = usedColumns[u];
+                if (c >= fields.size() || parseNumber(fields[c], columns[u][r]) != NumberParse::OK) {
+                    valid[r] = 0;
+                }
+            }
+            fallback[r] = !vectorizable;
+        }
+
+        // Evaluate the chunk a column at a time
+        operands.clear();
+        if (vectorizable) {
+            auto levelBuffer = [&]() {  // Scratch for the next stack level
+                while (scratch.size() <= operands.size()) scratch.emplace_back(kChunkRows);
+                return scratch[operands.size()].data();
+            };
+            auto pushBuffer = [&](double value) {
+                double* buffer = levelBuffer();
+                std::fill(buffer, buffer + n, value);
+                operands.push_back(buffer);
+            };
+            auto pop = [&]() {
+                if (operands.empty()) return zeros.data();
+                const double* top = operands.back();
+                operands.pop_back();
+                return top;
+            };
+            for (size_t i = 0; i < code.size(); ++i) {
+                const Instruction& ins = code[i];
+                if (ins.code == OpCode::PUSH || ins.code == OpCode::INLINE) {
+                    pushBuffer(ins.value);
+                } else if (ins.code == OpCode::LOAD || ins.code == OpCode::REGISTER) {
+                    if (slot[i] >= 0) {
+                        operands.push_back(columns[slot[i]].data());
+                    } else {
+                        pushBuffer(*findVariable(ins.symbol));
+                    }
+                }
+                if (ins.code == OpCode::CALL || ins.code == OpCode::APPLY || ins.code == OpCode::INLINE) {
+                    const double* x = pop();
+                    const double* y = ins.op->type == OperatorType::BINARY ? pop() : nullptr;
+                    double* result = levelBuffer();
+                    ins.op->kernel(*this, y, x, result, fallback.data(), n);
+                    operands.push_back(result);
+                }
+            }
+        }
+
+        for (size_t r = 0; r < n; ++r) {
+            out_->write(rows[r]);
+            out_->write(",");
+            if (!valid[r]) {
+                // Missing or non-numeric field: empty result
+            } else if (!fallback[r]) {
+                if (!operands.empty()) out_->write(formatNumber(operands.back()[r]));
+            } else {
+                for (size_t u = 0; u < usedIds.size(); ++u) {
+                    bindVariable(usedIds[u], columns[u][r]);
+                }
+                stack_.clear();
+                lastX_ = 0.0;
+                stackLiftEnabled_ = true;
+                out_ = &diagnostics;
+                runProgram(program);
+                out_ = csvOut;
+                resultPending_ = false;
+                if (!stack_.empty()) out_->write(formatNumber(stack_.peek()));
+                if (liveArrays_) sweepArrays();
+            }
+            out_->write("\n");
+        }
+        flushOutput();
+    }
+    flushOutput();
+}
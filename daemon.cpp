@@ -0,0 +1,335 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "daemon.h"
+#include "rpn.h"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ============================================================================
+// DAEMON PROTOCOL
+// ============================================================================
+//
+// One expression per connection.  The client sends
+//
+//     flags '\n' working-directory '\n' expression
+//
+// and closes its side; flags holds 'q' (quiet) and/or 'p' (profile).  The
+// daemon answers with frames of a channel byte ('1' stdout, '2' stderr), a
+// native-endian uint32 length and that many bytes, then closes.
+
+namespace {
+
+const size_t kMaxRequest = 16 * 1024 * 1024;
+const size_t kMaxClients = 64;  // Connections evaluated at once; the rest wait in the backlog
+
+bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::read(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof addr.sun_path) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Connected socket, or -1
+int connectTo(const std::string& path) {
+    sockaddr_un addr;
+    if (!makeAddress(path, addr)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Writes output back to the client as frames.  Results are buffered like
+// StdioSink's; errors flush them first so the client sees both in order.
+// A client that went away is ignored; the expression still runs to the end.
+class SocketSink : public OutputSink {
+public:
+    explicit SocketSink(int fd) : fd_(fd) {}
+
+    void write(std::string_view text) override {
+        buffer_.append(text.data(), text.size());
+        if (buffer_.size() >= kFlushThreshold) flush();
+    }
+    void writeError(std::string_view text) override {
+        flush();
+        send('2', text);
+    }
+    void flush() override {
+        if (buffer_.empty()) return;
+        send('1', buffer_);
+        buffer_.clear();
+    }
+
+private:
+    static constexpr size_t kFlushThreshold = 64 * 1024;
+    int fd_;
+    bool failed_ = false;
+    std::string buffer_;
+
+    void send(char channel, std::string_view text) {
+        char header[1 + sizeof(std::uint32_t)];
+        std::uint32_t size = static_cast<std::uint32_t>(text.size());
+        header[0] = channel;
+        std::memcpy(header + 1, &size, sizeof size);
+        failed_ = failed_ || !sendAll(fd_, header, sizeof header) ||
+                  !sendAll(fd_, text.data(), text.size());
+    }
+};
+
+volatile std::sig_atomic_t g_stopRequested = 0;
+
+void requestStop(int) {
+    g_stopRequested = 1;
+}
+
+}  // namespace
+
+// ============================================================================
+// SERVER
+// ============================================================================
+
+// The configuration is loaded once, and again before a connection if the
+// file has changed since.  Each connection runs on its own thread with a
+// copy of this calculator, so stacks, variables and settings are private to
+// it, while the operator registry snapshot is shared read-only (as for
+// --jobs workers, defining operators is refused; clients run those locally).
+void RPNCalculator::serve(const std::string& socketPath) {
+    loadConfig();
+    sharedRegistry_ = true;
+    refreshRegistry();
+    compileUserOperators();
+
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr)) {
+        printError("Error: Socket path '" + socketPath + "' is too long");
+        return;
+    }
+    int probe = connectTo(socketPath);
+    if (probe >= 0) {
+        ::close(probe);
+        printError("Error: A daemon is already listening on '" + socketPath + "'");
+        return;
+    }
+    struct stat st;
+    if (::lstat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        ::unlink(socketPath.c_str());  // Left behind by a daemon that died
+    }
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    mode_t mask = ::umask(077);  // Only this user may connect
+    bool bound = listener >= 0 &&
+                 ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0;
+    ::umask(mask);
+    if (!bound || ::listen(listener, SOMAXCONN) != 0) {
+        printError("Error: Cannot listen on '" + socketPath + "': " + std::strerror(errno));
+        if (listener >= 0) ::close(listener);
+        return;
+    }
+
+    // SIGINT/SIGTERM interrupt accept() (no SA_RESTART) to shut down cleanly
+    struct sigaction action;
+    std::memset(&action, 0, sizeof action);
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    printStatus("Listening on " + socketPath);
+    out_->flush();
+
+    std::mutex mutex;
+    std::condition_variable idle;  // A connection finished
+    size_t active = 0;
+    while (!g_stopRequested) {
+        {
+            // Signals do not wake a condition variable, so poll for a stop
+            std::unique_lock<std::mutex> lock(mutex);
+            while (active >= kMaxClients && !g_stopRequested) {
+                idle.wait_for(lock, std::chrono::milliseconds(100));
+            }
+        }
+        if (g_stopRequested) break;
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            printError(std::string("Error: accept: ") + std::strerror(errno));
+            break;
+        }
+        // The socket's mode already keeps other users out; check the peer too
+        ucred peer;
+        socklen_t peerSize = sizeof peer;
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &peerSize) != 0 ||
+            peer.uid != ::geteuid()) {
+            printError("Error: Refused a connection from another user");
+            ::close(fd);
+            continue;
+        }
+        // Pick up definitions made since the last connection; running
+        // connections keep the calculator they were copied from
+        if (configChanged()) {
+            reloadConfig();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active++;
+        }
+        // Connection threads leave the signals to this one
+        sigset_t signals, saved;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        ::pthread_sigmask(SIG_BLOCK, &signals, &saved);
+        std::thread([calc = *this, fd, &mutex, &idle, &active]() mutable {
+            calc.serveClient(fd);
+            ::close(fd);
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+            idle.notify_all();
+        }).detach();
+        ::pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+    }
+
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&] { return active == 0; });
+}
+
+void RPNCalculator::serveClient(int fd) {
+    std::string request;
+    char block[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(fd, block, sizeof block);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        request.append(block, n);
+        if (request.size() > kMaxRequest) return;
+    }
+    size_t flagsEnd = request.find('\n');
+    size_t dirEnd = flagsEnd == std::string::npos ? flagsEnd : request.find('\n', flagsEnd + 1);
+    if (dirEnd == std::string::npos) return;  // Not a client
+    std::string_view flags(request.data(), flagsEnd);
+
+    SocketSink sink(fd);
+    out_ = &sink;
+    workingDir_ = request.substr(flagsEnd + 1, dirEnd - flagsEnd - 1);
+    if (flags.find('q') != std::string_view::npos) setQuiet(true);
+    if (flags.find('p') != std::string_view::npos) setProfiling(true);
+
+    processLine(request.substr(dirEnd + 1));
+    finishProfile();
+    out_->flush();
+}
+
+// ============================================================================
+// CLIENT
+// ============================================================================
+
+std::string daemonSocketPath() {
+    if (const char* path = std::getenv("RPN_SOCKET")) {
+        return path;
+    }
+    if (const char* dir = std::getenv("XDG_RUNTIME_DIR")) {
+        return std::string(dir) + "/rpn.sock";
+    }
+    return "/tmp/rpn-" + std::to_string(::getuid()) + ".sock";
+}
+
+bool evaluateOnDaemon(const std::string& socketPath, const std::string& expr,
+                      bool quiet, bool profile) {
+    // Only trust a socket this user created
+    struct stat st;
+    if (::lstat(socketPath.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode) || st.st_uid != ::getuid()) {
+        return false;
+    }
+    // Defining or deleting an operator ('name{ ... }', 'name{}') writes
+    // ~/.rpn, which only a local run does; the daemon reloads it afterwards
+    if (expr.find('{') != std::string::npos) {
+        return false;
+    }
+    int fd = connectTo(socketPath);
+    if (fd < 0) return false;
+
+    std::string request;
+    if (quiet) request += 'q';
+    if (profile) request += 'p';
+    request += '\n';
+    char cwd[4096];
+    if (::getcwd(cwd, sizeof cwd)) request += cwd;
+    request += '\n';
+    request += expr;
+    bool sent = sendAll(fd, request.data(), request.size()) && ::shutdown(fd, SHUT_WR) == 0;
+
+    // Once sent, the daemon owns the request: no local retry after this
+    char header[1 + sizeof(std::uint32_t)];
+    std::string text;
+    while (sent && readAll(fd, header, sizeof header)) {
+        std::uint32_t size;
+        std::memcpy(&size, header + 1, sizeof size);
+        text.resize(size);
+        if (!readAll(fd, &text[0], size)) break;
+        if (header[0] == '2') {
+            std::fflush(stdout);  // Keep the two streams in order
+            std::fwrite(text.data(), 1, size, stderr);
+        } else {
+            std::fwrite(text.data(), 1, size, stdout);
+        }
+    }
+    std::fflush(stdout);
+    ::close(fd);
+    return sent;
+}
@@ -0,0 +1,34 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <string>
+
+// Client side of --daemon (daemon.cpp).  The server is
+// RPNCalculator::serve(); the client needs no calculator of its own.
+
+// $RPN_SOCKET, else rpn.sock in $XDG_RUNTIME_DIR, else /tmp/rpn-<uid>.sock
+std::string daemonSocketPath();
+
+// Evaluate expr on the daemon listening at socketPath, copying its output to
+// stdout and stderr.  Returns false, having printed nothing, if no daemon
+// owned by this user is listening there, or if expr defines or deletes an
+// operator, which must run locally.
+bool evaluateOnDaemon(const std::string& socketPath, const std::string& expr,
+                      bool quiet, bool profile);
+
+#endif // DAEMON_H
@@ -14,36 +14,119 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "rpn.h"
+#include "daemon.h"
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <cstdlib>
+#include <vector>
 
 void printUsage(const char* progname) {
-    std::cerr << "Usage: " << progname << " [-e expression]" << std::endl;
+    std::cerr << "Usage: " << progname << " [-q] [--prof] [-e expression | --stream [--carry | --jobs n] |" << std::endl;
+    std::cerr << "       --csv file --expr expression | --daemon | --client [-e] expression]" << std::endl;
     std::cerr << "  -e expression  Evaluate expression and exit" << std::endl;
+    std::cerr << "  --stream       Evaluate each stdin line, print one result per line" << std::endl;
+    std::cerr << "  --carry        With --stream, keep the stack between lines" << std::endl;
+    std::cerr << "  --jobs n       With --stream, evaluate lines on n threads (0 = all cores)" << std::endl;
+    std::cerr << "  --csv file     Copy a CSV file, appending a result column computed by --expr" << std::endl;
+    std::cerr << "  --expr expr    With --csv, expression evaluated per row (columns are variables)" << std::endl;
+    std::cerr << "  --daemon       Keep warm state and evaluate --client requests on a Unix socket" << std::endl;
+    std::cerr << "  --client       Evaluate on the running daemon (locally if there is none)" << std::endl;
+    std::cerr << "  -q             Quiet: only print the final result of each line" << std::endl;
+    std::cerr << "  --prof         Profile operator calls (JSON on stderr at exit, or 'prof' interactively)" << std::endl;
     std::cerr << "  -h, --help     Show this help" << std::endl;
     std::cerr << "  (no args)      Start interactive mode" << std::endl;
 }
 
+// Options whose next argument is their value
+static bool takesValue(const char* arg) {
+    return std::strcmp(arg, "-e") == 0 || std::strcmp(arg, "--csv") == 0 ||
+           std::strcmp(arg, "--expr") == 0 || std::strcmp(arg, "--jobs") == 0;
+}
+
 int main(int argc, char* argv[]) {
+    // -q and --prof apply to every mode and may appear anywhere; the rest
+    // keep their order.  Option values are never taken for flags.
+    bool quiet = false, profile = false;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (std::strcmp(argv[i], "--prof") == 0) {
+            profile = true;
+        } else {
+            args.push_back(argv[i]);
+            if (takesValue(argv[i]) && i + 1 < argc) {
+                args.push_back(argv[++i]);
+            }
+        }
+    }
+    const char* const* arg = args.data();
+    size_t nargs = args.size();
+
+    // --client [-e] expression: checked before any calculator state is built,
+    // which is the startup cost the daemon saves
+    if (nargs >= 2 && nargs <= 3 && std::strcmp(arg[0], "--client") == 0) {
+        if (nargs == 3 && std::strcmp(arg[1], "-e") != 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (evaluateOnDaemon(daemonSocketPath(), arg[nargs - 1], quiet, profile)) {
+            return 0;
+        }
+        arg++;  // No daemon: evaluate here as if --client were absent
+        nargs--;
+    }
+
     RPNCalculator calc;
+    if (quiet) calc.setQuiet(true);
+    if (profile) calc.setProfiling(true);
     
-    if (argc == 1) {
+    if (nargs == 0) {
         // No arguments: interactive mode
         calc.run();
-    } else if (argc == 2 && (std::strcmp(argv[1], "-h") == 0 || std::strcmp(argv[1], "--help") == 0)) {
+    } else if (nargs == 1 && (std::strcmp(arg[0], "-h") == 0 || std::strcmp(arg[0], "--help") == 0)) {
         printUsage(argv[0]);
         return 0;
-    } else if (argc == 3 && std::strcmp(argv[1], "-e") == 0) {
+    } else if (nargs == 3 && std::strcmp(arg[0], "--stream") == 0 &&
+               std::strcmp(arg[1], "--jobs") == 0) {
+        // --stream --jobs n: independent lines evaluated in parallel
+        char* end;
+        long jobs = std::strtol(arg[2], &end, 10);
+        if (*end != '\0' || jobs < 0 || jobs > 1024) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        calc.streamParallel(stdin, static_cast<unsigned>(jobs));
+    } else if (nargs >= 1 && nargs <= 2 && std::strcmp(arg[0], "--stream") == 0) {
+        // --stream [--carry]: one expression per stdin line
+        bool carry = nargs == 2 && std::strcmp(arg[1], "--carry") == 0;
+        if (nargs == 2 && !carry) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        calc.stream(stdin, carry);
+    } else if (nargs == 4 && std::strcmp(arg[0], "--csv") == 0 &&
+               std::strcmp(arg[2], "--expr") == 0) {
+        // --csv file --expr expression: header names are bound per row
+        calc.evaluateCsv(arg[1], arg[3]);
+    } else if (nargs == 1 && std::strcmp(arg[0], "--daemon") == 0) {
+        // --daemon: serve --client requests until SIGINT/SIGTERM
+        calc.serve(daemonSocketPath());
+        return 0;
+    } else if (nargs == 2 && std::strcmp(arg[0], "-e") == 0) {
         // -e expression: evaluate and exit
-        calc.evaluate(argv[2]);
-    } else if (argc == 2 && std::strcmp(argv[1], "-e") != 0) {
+        calc.evaluate(arg[1]);
+    } else if (nargs == 1 && std::strcmp(arg[0], "-e") != 0) {
         // Single argument without -e: treat as expression
-        calc.evaluate(argv[1]);
+        calc.evaluate(arg[0]);
     } else {
         printUsage(argv[0]);
         return 1;
     }
-    
+
+    if (nargs > 0) {
+        calc.finishProfile();  // Batch modes report the profile at exit
+    }
     return 0;
 }
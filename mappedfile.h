@@ -0,0 +1,67 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole file.  ok() is false if it could not be
+// opened or mapped, with errno set; an empty file maps to empty text.
+class MappedFile {
+public:
+    explicit MappedFile(const char* path, int advice = MADV_NORMAL) {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0) {
+            if (st.st_size == 0) {
+                ok_ = true;  // Nothing to map
+            } else {
+                void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    if (advice != MADV_NORMAL) ::madvise(data, st.st_size, advice);
+                    data_ = static_cast<const char*>(data);
+                    size_ = st.st_size;
+                    ok_ = true;
+                }
+            }
+        }
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+    }
+    ~MappedFile() {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return ok_; }
+    std::string_view text() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool ok_ = false;
+};
+
+#endif // MAPPEDFILE_H
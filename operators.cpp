@@ -14,220 +14,149 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "operators.h"
+#include "array.h"
 #include "rpn.h"
 #include <cmath>
-#include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <cstdio>
 #include <algorithm>
+#include <array>
 #include <random>
 
-// Singleton instance
-OperatorRegistry& OperatorRegistry::instance() {
-    static OperatorRegistry registry;
-    return registry;
-}
-
-OperatorRegistry::OperatorRegistry() {
-    initializeOperators();
-}
-
-void OperatorRegistry::registerOperator(const Operator& op) {
-    operators_[op.name] = op;
-    names_len_desc_dirty_ = true;
-    completions_dirty_ = true;
-}
-
-void OperatorRegistry::removeOperator(const std::string& name) {
-    operators_.erase(name);
-    names_len_desc_dirty_ = true;
-    completions_dirty_ = true;
-}
+// ============================================================================
+// OPERATOR KERNELS
+// ============================================================================
+//
+// Built-in operators are table entries made from these at compile time.  An
+// operator's arithmetic is a plain function taking one operand (x) or two
+// (y, x), and its arity is read off that signature.  Each template is
+// instantiated with the arithmetic as a template argument, so the same
+// kernel is inlined into the scalar operator, the form the bytecode VM
+// applies (Operator::scalar) and the element-wise array loop.
 
-bool OperatorRegistry::hasOperator(const std::string& name) const {
-    return operators_.find(name) != operators_.end();
-}
+template <typename Fn> struct ArityOf;
+template <typename R, typename... Operands>
+struct ArityOf<R (*)(RPNCalculator&, Operands...)> {
+    static constexpr int value = sizeof...(Operands);
+    static_assert(value == 1 || value == 2, "Kernels take x or y, x");
+};
+template <auto Fn>
+constexpr int kArity = ArityOf<decltype(Fn)>::value;
 
-const Operator* OperatorRegistry::getOperator(const std::string& name) const {
-    auto it = operators_.find(name);
-    return it != operators_.end() ? &it->second : nullptr;
-}
-
-std::vector<std::string> OperatorRegistry::getAllNames() const {
-    std::vector<std::string> names;
-    names.reserve(operators_.size());
-    for (const auto& pair : operators_) {
-        names.push_back(pair.first);
+// Fn of the operands (y ignored when unary)
+template <auto Fn>
+static inline auto apply(RPNCalculator& calc, [[maybe_unused]] double y, double x) {
+    if constexpr (kArity<Fn> == 1) {
+        return Fn(calc, x);
+    } else {
+        return Fn(calc, y, x);
     }
-    return names;
 }
 
-std::vector<std::string> OperatorRegistry::getNamesByCategory(OperatorCategory category) const {
-    std::vector<std::string> names;
-    for (const auto& pair : operators_) {
-        if (pair.second.category == category) {
-            names.push_back(pair.first);
-        }
-    }
-    return names;
+// Simple: pop, compute, push, print
+template <auto Fn>
+static void scalarOp(RPNCalculator& calc, const Operator&) {
+    double x = calc.popStack();
+    double y = kArity<Fn> == 2 ? calc.popStack() : 0.0;
+    calc.lastX_ = x;  // Save LASTX (the last operand)
+    double result = apply<Fn>(calc, y, x);
+    calc.pushStack(result);
+    calc.print(result);
+    calc.stackLiftEnabled_ = true;  // Enable stack lift after operation
 }
 
-std::string OperatorRegistry::categoryName(OperatorCategory category) {
-    switch (category) {
-        case OperatorCategory::ARITHMETIC: return "Arithmetic";
-        case OperatorCategory::TRIGONOMETRIC: return "Trigonometric";
-        case OperatorCategory::HYPERBOLIC: return "Hyperbolic";
-        case OperatorCategory::LOGARITHMIC: return "Logarithmic";
-        case OperatorCategory::STACK: return "Stack";
-        case OperatorCategory::CONVERSION: return "Unit Conversion";
-        case OperatorCategory::MISCELLANEOUS: return "Miscellaneous";
-        case OperatorCategory::USER: return "User-defined";
+// Guarded: same as simple but checks NaN/infinity and restores operands on error
+template <auto Fn>
+static void guardedOp(RPNCalculator& calc, const Operator&) {
+    double x = calc.popStack();
+    double y = kArity<Fn> == 2 ? calc.popStack() : 0.0;
+    calc.lastX_ = x;  // Save LASTX
+    double result = apply<Fn>(calc, y, x);
+    if (!std::isfinite(result)) {
+        calc.printError(std::isnan(result) ? "Error: Result is not a number" : "Error: Result is infinity");
+        if (kArity<Fn> == 2) calc.pushStack(y);
+        calc.pushStack(x);
+        return;
     }
-    return "Unknown";
+    calc.pushStack(result);
+    calc.print(result);
+    calc.stackLiftEnabled_ = true;  // Enable stack lift after operation
 }
 
-const std::vector<OperatorCategory>& OperatorRegistry::allCategories() {
-    static std::vector<OperatorCategory> categories = {
-        OperatorCategory::ARITHMETIC,
-        OperatorCategory::TRIGONOMETRIC,
-        OperatorCategory::HYPERBOLIC,
-        OperatorCategory::LOGARITHMIC,
-        OperatorCategory::STACK,
-        OperatorCategory::CONVERSION,
-        OperatorCategory::MISCELLANEOUS,
-        OperatorCategory::USER
-    };
-    return categories;
+// The VM's form: the arithmetic alone, with the operands already popped
+template <auto Fn>
+static double scalarForm(RPNCalculator& calc, double y, double x) {
+    return apply<Fn>(calc, y, x);
 }
 
-const std::vector<std::string>& OperatorRegistry::getNamesSortedByLengthDesc() {
-    if (names_len_desc_dirty_) {
-        names_len_desc_cache_.clear();
-        names_len_desc_cache_.reserve(operators_.size());
-        for (const auto& kv : operators_) names_len_desc_cache_.push_back(kv.first);
-        std::sort(names_len_desc_cache_.begin(), names_len_desc_cache_.end(),
-                  [](const std::string& a, const std::string& b) {
-                      if (a.size() != b.size()) return a.size() > b.size();
-                      return a < b; // stable ordering for equal lengths
-                  });
-        names_len_desc_dirty_ = false;
+// Element-wise kernels.  Plain loops over inlined arithmetic, which the
+// compiler vectorizes where the arithmetic allows.  y is null when unary.
+template <auto Fn>
+static void elementKernel(RPNCalculator& calc, const double* y, const double* x,
+                          double* out, unsigned char*, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = apply<Fn>(calc, kArity<Fn> == 2 ? y[i] : 0.0, x[i]);
     }
-    return names_len_desc_cache_;
-}
-
-void OperatorRegistry::setBuiltinCompletions(const std::vector<std::string>& builtins) {
-    builtins_ = builtins;
-    completions_dirty_ = true;
 }
 
-const std::vector<std::string>& OperatorRegistry::completions() {
-    if (completions_dirty_) {
-        completions_cache_ = getAllNames();
-        // add builtins not in registry
-        completions_cache_.insert(completions_cache_.end(), builtins_.begin(), builtins_.end());
-        std::sort(completions_cache_.begin(), completions_cache_.end());
-        completions_cache_.erase(std::unique(completions_cache_.begin(), completions_cache_.end()), completions_cache_.end());
-        completions_dirty_ = false;
+// For operators that validate their operands: rows failing the check are
+// flagged so the scalar operator can report the error.  The check comes
+// first since out may be the same buffer as an operand.
+template <auto Fn, auto Invalid>
+static void checkedKernel(RPNCalculator& calc, const double* y, const double* x,
+                          double* out, unsigned char* fallback, size_t n) {
+    static_assert(kArity<Fn> == kArity<Invalid>, "Check and arithmetic take the same operands");
+    for (size_t i = 0; i < n; ++i) {
+        double yi = kArity<Fn> == 2 ? y[i] : 0.0;
+        fallback[i] |= apply<Invalid>(calc, yi, x[i]);
+        out[i] = apply<Fn>(calc, yi, x[i]);
     }
-    return completions_cache_;
 }
 
-void OperatorRegistry::initializeOperators() {
-    registerArithmetic();
-    registerTrigonometric();
-    registerHyperbolic();
-    registerLogarithmic();
-    registerStackOperations();
-    registerUnitConversions();
-    registerMiscellaneous();
+template <auto Fn>
+static void guardedKernel(RPNCalculator& calc, const double* y, const double* x,
+                          double* out, unsigned char* fallback, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = apply<Fn>(calc, kArity<Fn> == 2 ? y[i] : 0.0, x[i]);
+        fallback[i] |= !std::isfinite(out[i]);
+    }
 }
 
-void OperatorRegistry::registerUnaryOp(const std::string& name, OperatorCategory cat,
-                                        UnaryFn fn, const std::string& desc) {
-    registerOperator({name, OperatorType::UNARY, cat, [fn](RPNCalculator& calc) {
-        double x = calc.popStack();
-        calc.lastX_ = x;  // Save LASTX
-        double result = fn(calc, x);
-        calc.pushStack(result);
-        calc.print(result);
-        calc.stackLiftEnabled_ = true;  // Enable stack lift after operation
-    }, desc});
-}
+// Table entries for the common shapes
+template <auto Fn>
+static constexpr OperatorType kOperatorType = kArity<Fn> == 1 ? OperatorType::UNARY : OperatorType::BINARY;
 
-void OperatorRegistry::registerBinaryOp(const std::string& name, OperatorCategory cat,
-                                         BinaryFn fn, const std::string& desc) {
-    registerOperator({name, OperatorType::BINARY, cat, [fn](RPNCalculator& calc) {
-        double x = calc.popStack();
-        double y = calc.popStack();
-        calc.lastX_ = x;  // Save LASTX (typically save the last operand)
-        double result = fn(calc, y, x);
-        calc.pushStack(result);
-        calc.print(result);
-        calc.stackLiftEnabled_ = true;  // Enable stack lift after operation
-    }, desc});
+template <auto Fn>
+static constexpr Operator simple(std::string_view name, OperatorCategory cat, std::string_view desc) {
+    return {name, kOperatorType<Fn>, cat, scalarOp<Fn>, desc, elementKernel<Fn>, scalarForm<Fn>};
 }
 
-void OperatorRegistry::registerGuardedUnaryOp(const std::string& name, OperatorCategory cat,
-                                               UnaryFn fn, const std::string& desc) {
-    registerOperator({name, OperatorType::UNARY, cat, [fn](RPNCalculator& calc) {
-        double x = calc.popStack();
-        calc.lastX_ = x;  // Save LASTX
-        double result = fn(calc, x);
-        if (std::isnan(result)) {
-            calc.printError("Error: Result is not a number");
-            calc.pushStack(x);
-            return;
-        }
-        if (std::isinf(result)) {
-            calc.printError("Error: Result is infinity");
-            calc.pushStack(x);
-            return;
-        }
-        calc.pushStack(result);
-        calc.print(result);
-        calc.stackLiftEnabled_ = true;  // Enable stack lift after operation
-    }, desc});
-}
-
-void OperatorRegistry::registerGuardedBinaryOp(const std::string& name, OperatorCategory cat,
-                                                BinaryFn fn, const std::string& desc) {
-    registerOperator({name, OperatorType::BINARY, cat, [fn](RPNCalculator& calc) {
-        double x = calc.popStack();
-        double y = calc.popStack();
-        calc.lastX_ = x;  // Save LASTX
-        double result = fn(calc, y, x);
-        if (std::isnan(result)) {
-            calc.printError("Error: Result is not a number");
-            calc.pushStack(y);
-            calc.pushStack(x);
-            return;
-        }
-        if (std::isinf(result)) {
-            calc.printError("Error: Result is infinity");
-            calc.pushStack(y);
-            calc.pushStack(x);
-            return;
-        }
-        calc.pushStack(result);
-        calc.print(result);
-        calc.stackLiftEnabled_ = true;  // Enable stack lift after operation
-    }, desc});
+template <auto Fn>
+static constexpr Operator guarded(std::string_view name, OperatorCategory cat, std::string_view desc) {
+    return {name, kOperatorType<Fn>, cat, guardedOp<Fn>, desc, guardedKernel<Fn>};
 }
 
 // ============================================================================
 // ARITHMETIC OPERATORS
 // ============================================================================
-void OperatorRegistry::registerArithmetic() {
-    registerBinaryOp("+", OperatorCategory::ARITHMETIC,
-        [](RPNCalculator&, double y, double x) { return y + x; }, "Addition");
-    registerBinaryOp("-", OperatorCategory::ARITHMETIC,
-        [](RPNCalculator&, double y, double x) { return y - x; }, "Subtraction");
-    registerBinaryOp("*", OperatorCategory::ARITHMETIC,
-        [](RPNCalculator&, double y, double x) { return y * x; }, "Multiplication");
-    
+static double add(RPNCalculator&, double y, double x) { return y + x; }
+static double subtract(RPNCalculator&, double y, double x) { return y - x; }
+static double multiply(RPNCalculator&, double y, double x) { return y * x; }
+static double divide(RPNCalculator&, double y, double x) { return y / x; }
+static double modulo(RPNCalculator&, double y, double x) { return std::fmod(y, x); }
+static double power(RPNCalculator&, double y, double x) { return std::pow(y, x); }
+static double percentChange(RPNCalculator&, double y, double x) { return ((x - y) / y) * 100.0; }
+static bool zeroX(RPNCalculator&, double, double x) { return x == 0; }
+static bool zeroY(RPNCalculator&, double y, double) { return y == 0; }
+
+static constexpr Operator kArithmetic[] = {
+    simple<add>("+", OperatorCategory::ARITHMETIC, "Addition"),
+    simple<subtract>("-", OperatorCategory::ARITHMETIC, "Subtraction"),
+    simple<multiply>("*", OperatorCategory::ARITHMETIC, "Multiplication"),
+
     // Division — custom validation for zero
-    registerOperator({"/", OperatorType::BINARY, OperatorCategory::ARITHMETIC, [](RPNCalculator& calc) {
+    {"/", OperatorType::BINARY, OperatorCategory::ARITHMETIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         double y = calc.popStack();
         if (x == 0) {
@@ -239,10 +168,10 @@ void OperatorRegistry::registerArithmetic() {
         double result = y / x;
         calc.pushStack(result);
         calc.print(result);
-    }, "Division"});
-    
+    }, "Division", checkedKernel<divide, zeroX>},
+
     // Modulo — custom validation for zero
-    registerOperator({"%", OperatorType::BINARY, OperatorCategory::ARITHMETIC, [](RPNCalculator& calc) {
+    {"%", OperatorType::BINARY, OperatorCategory::ARITHMETIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         double y = calc.popStack();
         if (x == 0) {
@@ -254,13 +183,12 @@ void OperatorRegistry::registerArithmetic() {
         double result = std::fmod(y, x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Modulo"});
-    
-    registerGuardedBinaryOp("^", OperatorCategory::ARITHMETIC,
-        [](RPNCalculator&, double y, double x) { return std::pow(y, x); }, "Power");
-    
+    }, "Modulo", checkedKernel<modulo, zeroX>},
+
+    guarded<power>("^", OperatorCategory::ARITHMETIC, "Power"),
+
     // Percent change: ((x - y) / y) * 100
-    registerOperator({"%ch", OperatorType::BINARY, OperatorCategory::ARITHMETIC, [](RPNCalculator& calc) {
+    {"%ch", OperatorType::BINARY, OperatorCategory::ARITHMETIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         double y = calc.popStack();
         if (y == 0) {
@@ -273,20 +201,48 @@ void OperatorRegistry::registerArithmetic() {
         double result = ((x - y) / y) * 100.0;
         calc.pushStack(result);
         calc.print(result);
-    }, "Percent change ((x-y)/y * 100)"});
-}
+    }, "Percent change ((x-y)/y * 100)", checkedKernel<percentChange, zeroY>},
+};
+
+// ============================================================================
+// COMPARISON OPERATORS
+// ============================================================================
+// 1 if the comparison of y with x holds, else 0 (element-wise on arrays)
+static double lessThan(RPNCalculator&, double y, double x) { return y < x ? 1.0 : 0.0; }
+static double greaterThan(RPNCalculator&, double y, double x) { return y > x ? 1.0 : 0.0; }
+static double lessOrEqual(RPNCalculator&, double y, double x) { return y <= x ? 1.0 : 0.0; }
+static double greaterOrEqual(RPNCalculator&, double y, double x) { return y >= x ? 1.0 : 0.0; }
+static double equalTo(RPNCalculator&, double y, double x) { return y == x ? 1.0 : 0.0; }
+static double notEqualTo(RPNCalculator&, double y, double x) { return y != x ? 1.0 : 0.0; }
+
+static constexpr Operator kComparison[] = {
+    simple<lessThan>("<", OperatorCategory::COMPARISON, "Less than (1 if y < x, else 0)"),
+    simple<greaterThan>(">", OperatorCategory::COMPARISON, "Greater than (1 if y > x, else 0)"),
+    simple<lessOrEqual>("<=", OperatorCategory::COMPARISON, "Less than or equal"),
+    simple<greaterOrEqual>(">=", OperatorCategory::COMPARISON, "Greater than or equal"),
+    simple<equalTo>("==", OperatorCategory::COMPARISON, "Equal"),
+    simple<notEqualTo>("!=", OperatorCategory::COMPARISON, "Not equal"),
+};
 
 // ============================================================================
 // TRIGONOMETRIC OPERATORS
 // ============================================================================
-void OperatorRegistry::registerTrigonometric() {
-    registerUnaryOp("sin", OperatorCategory::TRIGONOMETRIC,
-        [](RPNCalculator& c, double x) { return std::sin(c.toRadians(x)); }, "Sine");
-    registerUnaryOp("cos", OperatorCategory::TRIGONOMETRIC,
-        [](RPNCalculator& c, double x) { return std::cos(c.toRadians(x)); }, "Cosine");
-    
+static double sine(RPNCalculator& c, double x) { return std::sin(c.toRadians(x)); }
+static double cosine(RPNCalculator& c, double x) { return std::cos(c.toRadians(x)); }
+static double tangent(RPNCalculator& c, double x) { return std::tan(c.toRadians(x)); }
+static double arcsine(RPNCalculator& c, double x) { return c.fromRadians(std::asin(x)); }
+static double arccosine(RPNCalculator& c, double x) { return c.fromRadians(std::acos(x)); }
+static double arctangent(RPNCalculator& c, double x) { return c.fromRadians(std::atan(x)); }
+static double arctangent2(RPNCalculator& c, double y, double x) { return c.fromRadians(std::atan2(y, x)); }
+static bool tangentUndefined(RPNCalculator& c, double x) { return std::abs(std::cos(c.toRadians(x))) < 1e-10; }
+static bool outsideUnitRange(RPNCalculator&, double x) { return x < -1 || x > 1; }
+
+static constexpr Operator kTrigonometric[] = {
+    simple<sine>("sin", OperatorCategory::TRIGONOMETRIC, "Sine"),
+    simple<cosine>("cos", OperatorCategory::TRIGONOMETRIC, "Cosine"),
+
     // Tangent — custom validation for cos near zero
-    registerOperator({"tan", OperatorType::UNARY, OperatorCategory::TRIGONOMETRIC, [](RPNCalculator& calc) {
+    {"tan", OperatorType::UNARY, OperatorCategory::TRIGONOMETRIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         double radians = calc.toRadians(x);
         double cosVal = std::cos(radians);
@@ -298,10 +254,10 @@ void OperatorRegistry::registerTrigonometric() {
         double result = std::tan(radians);
         calc.pushStack(result);
         calc.print(result);
-    }, "Tangent"});
-    
+    }, "Tangent", checkedKernel<tangent, tangentUndefined>},
+
     // Arcsine — custom range validation
-    registerOperator({"asin", OperatorType::UNARY, OperatorCategory::TRIGONOMETRIC, [](RPNCalculator& calc) {
+    {"asin", OperatorType::UNARY, OperatorCategory::TRIGONOMETRIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x < -1 || x > 1) {
             calc.printError("Error: asin argument must be in [-1, 1]");
@@ -311,10 +267,10 @@ void OperatorRegistry::registerTrigonometric() {
         double result = calc.fromRadians(std::asin(x));
         calc.pushStack(result);
         calc.print(result);
-    }, "Arcsine"});
-    
+    }, "Arcsine", checkedKernel<arcsine, outsideUnitRange>},
+
     // Arccosine — custom range validation
-    registerOperator({"acos", OperatorType::UNARY, OperatorCategory::TRIGONOMETRIC, [](RPNCalculator& calc) {
+    {"acos", OperatorType::UNARY, OperatorCategory::TRIGONOMETRIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x < -1 || x > 1) {
             calc.printError("Error: acos argument must be in [-1, 1]");
@@ -324,29 +280,32 @@ void OperatorRegistry::registerTrigonometric() {
         double result = calc.fromRadians(std::acos(x));
         calc.pushStack(result);
         calc.print(result);
-    }, "Arccosine"});
-    
-    registerUnaryOp("atan", OperatorCategory::TRIGONOMETRIC,
-        [](RPNCalculator& c, double x) { return c.fromRadians(std::atan(x)); }, "Arctangent");
-    registerBinaryOp("atan2", OperatorCategory::TRIGONOMETRIC,
-        [](RPNCalculator& c, double y, double x) { return c.fromRadians(std::atan2(y, x)); }, "Arctangent2");
-}
+    }, "Arccosine", checkedKernel<arccosine, outsideUnitRange>},
+
+    simple<arctangent>("atan", OperatorCategory::TRIGONOMETRIC, "Arctangent"),
+    simple<arctangent2>("atan2", OperatorCategory::TRIGONOMETRIC, "Arctangent2"),
+};
 
 // ============================================================================
 // HYPERBOLIC OPERATORS
 // ============================================================================
-void OperatorRegistry::registerHyperbolic() {
-    registerUnaryOp("sinh", OperatorCategory::HYPERBOLIC,
-        [](RPNCalculator&, double x) { return std::sinh(x); }, "Hyperbolic sine");
-    registerUnaryOp("cosh", OperatorCategory::HYPERBOLIC,
-        [](RPNCalculator&, double x) { return std::cosh(x); }, "Hyperbolic cosine");
-    registerUnaryOp("tanh", OperatorCategory::HYPERBOLIC,
-        [](RPNCalculator&, double x) { return std::tanh(x); }, "Hyperbolic tangent");
-    registerUnaryOp("asinh", OperatorCategory::HYPERBOLIC,
-        [](RPNCalculator&, double x) { return std::asinh(x); }, "Inverse hyperbolic sine");
-    
+static double hyperbolicSine(RPNCalculator&, double x) { return std::sinh(x); }
+static double hyperbolicCosine(RPNCalculator&, double x) { return std::cosh(x); }
+static double hyperbolicTangent(RPNCalculator&, double x) { return std::tanh(x); }
+static double inverseSinh(RPNCalculator&, double x) { return std::asinh(x); }
+static double inverseCosh(RPNCalculator&, double x) { return std::acosh(x); }
+static double inverseTanh(RPNCalculator&, double x) { return std::atanh(x); }
+static bool belowOne(RPNCalculator&, double x) { return x < 1; }
+static bool outsideOpenUnitRange(RPNCalculator&, double x) { return x <= -1 || x >= 1; }
+
+static constexpr Operator kHyperbolic[] = {
+    simple<hyperbolicSine>("sinh", OperatorCategory::HYPERBOLIC, "Hyperbolic sine"),
+    simple<hyperbolicCosine>("cosh", OperatorCategory::HYPERBOLIC, "Hyperbolic cosine"),
+    simple<hyperbolicTangent>("tanh", OperatorCategory::HYPERBOLIC, "Hyperbolic tangent"),
+    simple<inverseSinh>("asinh", OperatorCategory::HYPERBOLIC, "Inverse hyperbolic sine"),
+
     // acosh — custom range validation
-    registerOperator({"acosh", OperatorType::UNARY, OperatorCategory::HYPERBOLIC, [](RPNCalculator& calc) {
+    {"acosh", OperatorType::UNARY, OperatorCategory::HYPERBOLIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x < 1) {
             calc.printError("Error: acosh argument must be >= 1");
@@ -356,10 +315,10 @@ void OperatorRegistry::registerHyperbolic() {
         double result = std::acosh(x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Inverse hyperbolic cosine"});
-    
+    }, "Inverse hyperbolic cosine", checkedKernel<inverseCosh, belowOne>},
+
     // atanh — custom range validation
-    registerOperator({"atanh", OperatorType::UNARY, OperatorCategory::HYPERBOLIC, [](RPNCalculator& calc) {
+    {"atanh", OperatorType::UNARY, OperatorCategory::HYPERBOLIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x <= -1 || x >= 1) {
             calc.printError("Error: atanh argument must be in (-1, 1)");
@@ -369,15 +328,23 @@ void OperatorRegistry::registerHyperbolic() {
         double result = std::atanh(x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Inverse hyperbolic tangent"});
-}
+    }, "Inverse hyperbolic tangent", checkedKernel<inverseTanh, outsideOpenUnitRange>},
+};
 
 // ============================================================================
 // LOGARITHMIC/EXPONENTIAL OPERATORS
 // ============================================================================
-void OperatorRegistry::registerLogarithmic() {
+static double naturalLog(RPNCalculator&, double x) { return std::log(x); }
+static double commonLog(RPNCalculator&, double x) { return std::log10(x); }
+static double binaryLog(RPNCalculator&, double x) { return std::log2(x); }
+static double exponential(RPNCalculator&, double x) { return std::exp(x); }
+static double logBase(RPNCalculator&, double y, double x) { return std::log(y) / std::log(x); }
+static bool nonPositive(RPNCalculator&, double x) { return x <= 0; }
+static bool invalidLogBase(RPNCalculator&, double y, double x) { return y <= 0 || x <= 0 || x == 1; }
+
+static constexpr Operator kLogarithmic[] = {
     // ln, log, log2 — custom validation for non-positive input
-    registerOperator({"ln", OperatorType::UNARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc) {
+    {"ln", OperatorType::UNARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x <= 0) {
             calc.printError("Error: Logarithm of non-positive number");
@@ -387,9 +354,9 @@ void OperatorRegistry::registerLogarithmic() {
         double result = std::log(x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Natural logarithm"});
-    
-    registerOperator({"log", OperatorType::UNARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc) {
+    }, "Natural logarithm", checkedKernel<naturalLog, nonPositive>},
+
+    {"log", OperatorType::UNARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x <= 0) {
             calc.printError("Error: Logarithm of non-positive number");
@@ -399,12 +366,11 @@ void OperatorRegistry::registerLogarithmic() {
         double result = std::log10(x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Base-10 logarithm"});
-    
-    registerGuardedUnaryOp("exp", OperatorCategory::LOGARITHMIC,
-        [](RPNCalculator&, double x) { return std::exp(x); }, "Exponential (e^x)");
-    
-    registerOperator({"log2", OperatorType::UNARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc) {
+    }, "Base-10 logarithm", checkedKernel<commonLog, nonPositive>},
+
+    guarded<exponential>("exp", OperatorCategory::LOGARITHMIC, "Exponential (e^x)"),
+
+    {"log2", OperatorType::UNARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x <= 0) {
             calc.printError("Error: Logarithm of non-positive number");
@@ -414,10 +380,10 @@ void OperatorRegistry::registerLogarithmic() {
         double result = std::log2(x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Base-2 logarithm"});
-    
+    }, "Base-2 logarithm", checkedKernel<binaryLog, nonPositive>},
+
     // logb — custom validation for non-positive and base=1
-    registerOperator({"logb", OperatorType::BINARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc) {
+    {"logb", OperatorType::BINARY, OperatorCategory::LOGARITHMIC, [](RPNCalculator& calc, const Operator&) {
         double base = calc.popStack();
         double x = calc.popStack();
         if (x <= 0 || base <= 0) {
@@ -435,91 +401,125 @@ void OperatorRegistry::registerLogarithmic() {
         double result = std::log(x) / std::log(base);
         calc.pushStack(result);
         calc.print(result);
-    }, "Logarithm with arbitrary base (x base logb)"});
-}
+    }, "Logarithm with arbitrary base (x base logb)", checkedKernel<logBase, invalidLogBase>},
+};
 
 // ============================================================================
 // STACK OPERATIONS
 // ============================================================================
-void OperatorRegistry::registerStackOperations() {
+
+// Replace an array on top of the stack with reduce(elements).  An empty
+// array gives empty, or an error when the reduction has no identity.
+// Returns false if the top is not an array.
+template <typename Reduce>
+static bool reduceTopArray(RPNCalculator& calc, std::optional<double> empty, Reduce reduce) {
+    const std::vector<double>* values = calc.getArray(calc.peekStack());
+    if (!values) return false;
+    if (values->empty() && !empty) {
+        calc.printError("Error: Array is empty");
+        return true;
+    }
+    double result = values->empty() ? *empty : reduce(values->data(), values->size());
+    calc.popStack();
+    calc.pushStack(result);
+    calc.print(result);
+    return true;
+}
+
+// Pop every stack value, expanding arrays into their elements
+static std::vector<double> drainStack(RPNCalculator& calc) {
+    std::vector<double> values;
+    while (!calc.isStackEmpty()) {
+        double value = calc.popStack();
+        if (const std::vector<double>* elements = calc.getArray(value)) {
+            values.insert(values.end(), elements->begin(), elements->end());
+        } else {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+// Reverse top 2 / swap
+static void swapTop(RPNCalculator& calc, const Operator&) {
+    if (calc.stackSize() < 2) {
+        calc.printError("Error: Need at least 2 elements");
+        return;
+    }
+    calc.rollStack(1);
+}
+
+static constexpr Operator kStack[] = {
     // Print stack
-    registerOperator({"p", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    {"p", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         calc.printStack();
-    }, "Print stack"});
-    
+    }, "Print stack"},
+
     // Clear stack
-    registerOperator({"c", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    {"c", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         calc.clearStack();
         calc.printStatus("Stack cleared");
-    }, "Clear stack"});
-    
+    }, "Clear stack"},
+
     // Duplicate top
-    registerOperator({"d", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    {"d", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         if (calc.isStackEmpty()) {
             calc.printError("Error: Stack empty");
             return;
         }
         double val = calc.peekStack();
         calc.pushStack(val);
-    }, "Duplicate top"});
-    
-    // Reverse top 2 / swap
-    auto swapFunc = [](RPNCalculator& calc) {
-        if (calc.stackSize() < 2) {
-            calc.printError("Error: Need at least 2 elements");
-            return;
-        }
-        double x = calc.popStack();
-        double y = calc.popStack();
-        calc.pushStack(x);
-        calc.pushStack(y);
-    };
-    registerOperator({"r", OperatorType::NULLARY, OperatorCategory::STACK, swapFunc, "Reverse top 2"});
-    registerOperator({"swap", OperatorType::NULLARY, OperatorCategory::STACK, swapFunc, "Swap top 2 (alias for r)"});
-    
+    }, "Duplicate top"},
+
+    {"r", OperatorType::NULLARY, OperatorCategory::STACK, swapTop, "Reverse top 2"},
+    {"swap", OperatorType::NULLARY, OperatorCategory::STACK, swapTop, "Swap top 2 (alias for r)"},
+
     // Pop
-    registerOperator({"pop", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    {"pop", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         if (!calc.isStackEmpty()) {
             calc.popStack();
         }
-    }, "Pop top value"});
-    
-    registerOperator({"rdn", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    }, "Pop top value"},
+
+    // Roll down: top moves to the bottom
+    {"rdn", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         if (calc.stackSize() < 2) return;
-        std::vector<double> values;
-        while (!calc.isStackEmpty()) {
-            values.push_back(calc.popStack());
-        }
-        double top = values[0];
-        for (size_t i = 0; i < values.size() - 1; ++i) {
-            values[i] = values[i + 1];
-        }
-        values[values.size() - 1] = top;
-        for (auto it = values.rbegin(); it != values.rend(); ++it) {
-            calc.pushStack(*it);
-        }
+        calc.rollStackDown(calc.stackSize() - 1);
         calc.print(calc.peekStack());
-    }, "Roll down stack"});
-    
-    registerOperator({"rup", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    }, "Roll down stack"},
+
+    // Roll up: bottom moves to the top
+    {"rup", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         if (calc.stackSize() < 2) return;
-        std::vector<double> values;
-        while (!calc.isStackEmpty()) {
-            values.push_back(calc.popStack());
-        }
-        double bottom = values[values.size() - 1];
-        for (size_t i = values.size() - 1; i > 0; --i) {
-            values[i] = values[i - 1];
+        calc.rollStack(calc.stackSize() - 1);
+        calc.print(calc.peekStack());
+    }, "Roll up stack"},
+
+    // Pick / roll take a 1-based level from the stack (1 pick = d, 2 roll = swap)
+    {"pick", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        double n = calc.popStack();
+        if (n != std::floor(n) || n < 1 || n > calc.stackSize()) {
+            calc.printError("Error: Level must be an integer from 1 to the stack depth");
+            calc.pushStack(n);
+            return;
         }
-        values[0] = bottom;
-        for (auto it = values.rbegin(); it != values.rend(); ++it) {
-            calc.pushStack(*it);
+        calc.pickStack(static_cast<size_t>(n) - 1);
+        calc.print(calc.peekStack());
+    }, "Copy level n to top (n pick)"},
+
+    {"roll", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        double n = calc.popStack();
+        if (n != std::floor(n) || n < 1 || n > calc.stackSize()) {
+            calc.printError("Error: Level must be an integer from 1 to the stack depth");
+            calc.pushStack(n);
+            return;
         }
+        calc.rollStack(static_cast<size_t>(n) - 1);
         calc.print(calc.peekStack());
-    }, "Roll up stack"});
+    }, "Move level n to top (n roll)"},
 
     // Copy to clipboard (cross-platform)
-    registerOperator({"copy", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    {"copy", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
         double value = calc.peekStack();
         std::ostringstream oss;
         oss << std::setprecision(calc.getScale()) << value;
@@ -539,7 +539,7 @@ void OperatorRegistry::registerStackOperations() {
 #endif
             nullptr
         };
-        
+
         bool copied = false;
         for (int i = 0; commands[i] != nullptr; ++i) {
             FILE* pipe = popen(commands[i], "w");
@@ -553,14 +553,16 @@ void OperatorRegistry::registerStackOperations() {
                 }
             }
         }
-        
+
         if (!copied) {
             calc.printError("Error: Could not copy to clipboard");
         }
-    }, "Copy top to clipboard"});
-    
-    // Sum all stack values
-    registerOperator({"sum", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    }, "Copy top to clipboard"},
+
+    // Sum all stack values (arrays count each element), or the elements of
+    // an array on top
+    {"sum", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        if (reduceTopArray(calc, 0.0, arraySum)) return;
         if (calc.isStackEmpty()) {
             calc.pushStack(0);
             calc.print(0);
@@ -568,14 +570,17 @@ void OperatorRegistry::registerStackOperations() {
         }
         double total = 0;
         while (!calc.isStackEmpty()) {
-            total += calc.popStack();
+            double value = calc.popStack();
+            const std::vector<double>* values = calc.getArray(value);
+            total += values ? arraySum(values->data(), values->size()) : value;
         }
         calc.pushStack(total);
         calc.print(total);
-    }, "Sum all stack values"});
-    
+    }, "Sum all stack values (or of the array on top)"},
+
     // Product of all stack values
-    registerOperator({"prod", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc) {
+    {"prod", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        if (reduceTopArray(calc, 1.0, arrayProduct)) return;
         if (calc.isStackEmpty()) {
             calc.pushStack(1);
             calc.print(1);
@@ -583,68 +588,140 @@ void OperatorRegistry::registerStackOperations() {
         }
         double total = 1;
         while (!calc.isStackEmpty()) {
-            total *= calc.popStack();
+            double value = calc.popStack();
+            const std::vector<double>* values = calc.getArray(value);
+            total *= values ? arrayProduct(values->data(), values->size()) : value;
         }
         calc.pushStack(total);
         calc.print(total);
-    }, "Product of all stack values"});
-}
+    }, "Product of all stack values (or of the array on top)"},
+
+    {"min", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        if (reduceTopArray(calc, std::nullopt, arrayMin)) return;
+        std::vector<double> values = drainStack(calc);
+        if (values.empty()) {
+            calc.printError("Error: Stack is empty");
+            return;
+        }
+        double result = arrayMin(values.data(), values.size());
+        calc.pushStack(result);
+        calc.print(result);
+    }, "Minimum of all stack values (or of the array on top)"},
+
+    {"max", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        if (reduceTopArray(calc, std::nullopt, arrayMax)) return;
+        std::vector<double> values = drainStack(calc);
+        if (values.empty()) {
+            calc.printError("Error: Stack is empty");
+            return;
+        }
+        double result = arrayMax(values.data(), values.size());
+        calc.pushStack(result);
+        calc.print(result);
+    }, "Maximum of all stack values (or of the array on top)"},
+
+    {"mean", OperatorType::NULLARY, OperatorCategory::STACK, [](RPNCalculator& calc, const Operator&) {
+        auto mean = [](const double* values, size_t n) { return arraySum(values, n) / n; };
+        if (reduceTopArray(calc, std::nullopt, mean)) return;
+        std::vector<double> values = drainStack(calc);
+        if (values.empty()) {
+            calc.printError("Error: Stack is empty");
+            return;
+        }
+        double result = mean(values.data(), values.size());
+        calc.pushStack(result);
+        calc.print(result);
+    }, "Mean of all stack values (or of the array on top)"},
+};
 
 // ============================================================================
 // UNIT CONVERSIONS
 // ============================================================================
-void OperatorRegistry::registerUnitConversions() {
+static double celsiusToFahrenheit(RPNCalculator&, double x) { return x * 9.0 / 5.0 + 32.0; }
+static double fahrenheitToCelsius(RPNCalculator&, double x) { return (x - 32.0) * 5.0 / 9.0; }
+static double kilometersToMiles(RPNCalculator&, double x) { return x / 1.609344; }
+static double milesToKilometers(RPNCalculator&, double x) { return x * 1.609344; }
+static double metersToFeet(RPNCalculator&, double x) { return x / 0.3048; }
+static double feetToMeters(RPNCalculator&, double x) { return x * 0.3048; }
+static double centimetersToInches(RPNCalculator&, double x) { return x / 2.54; }
+static double inchesToCentimeters(RPNCalculator&, double x) { return x * 2.54; }
+static double kilogramsToPounds(RPNCalculator&, double x) { return x * 2.20462262; }
+static double poundsToKilograms(RPNCalculator&, double x) { return x / 2.20462262; }
+static double gramsToOunces(RPNCalculator&, double x) { return x / 28.3495231; }
+static double ouncesToGrams(RPNCalculator&, double x) { return x * 28.3495231; }
+static double litersToGallons(RPNCalculator&, double x) { return x / 3.78541178; }
+static double gallonsToLiters(RPNCalculator&, double x) { return x * 3.78541178; }
+static double btuToKilowattHours(RPNCalculator&, double x) { return x / 3412.14163; }
+static double kilowattHoursToBtu(RPNCalculator&, double x) { return x * 3412.14163; }
+
+static constexpr Operator kConversions[] = {
     // Temperature
-    registerUnaryOp("c>f", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 9.0 / 5.0 + 32.0; }, "Celsius to Fahrenheit (F = C * 9/5 + 32)");
-    registerUnaryOp("f>c", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return (x - 32.0) * 5.0 / 9.0; }, "Fahrenheit to Celsius (C = (F - 32) * 5/9)");
+    simple<celsiusToFahrenheit>("c>f", OperatorCategory::CONVERSION, "Celsius to Fahrenheit (F = C * 9/5 + 32)"),
+    simple<fahrenheitToCelsius>("f>c", OperatorCategory::CONVERSION, "Fahrenheit to Celsius (C = (F - 32) * 5/9)"),
     // Distance
-    registerUnaryOp("km>mi", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 1.609344; }, "Kilometers to miles (1 mi = 1.609344 km)");
-    registerUnaryOp("mi>km", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 1.609344; }, "Miles to kilometers (1 mi = 1.609344 km)");
-    registerUnaryOp("m>ft", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 0.3048; }, "Meters to feet (1 ft = 0.3048 m)");
-    registerUnaryOp("ft>m", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 0.3048; }, "Feet to meters (1 ft = 0.3048 m)");
-    registerUnaryOp("cm>in", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 2.54; }, "Centimeters to inches (1 in = 2.54 cm)");
-    registerUnaryOp("in>cm", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 2.54; }, "Inches to centimeters (1 in = 2.54 cm)");
+    simple<kilometersToMiles>("km>mi", OperatorCategory::CONVERSION, "Kilometers to miles (1 mi = 1.609344 km)"),
+    simple<milesToKilometers>("mi>km", OperatorCategory::CONVERSION, "Miles to kilometers (1 mi = 1.609344 km)"),
+    simple<metersToFeet>("m>ft", OperatorCategory::CONVERSION, "Meters to feet (1 ft = 0.3048 m)"),
+    simple<feetToMeters>("ft>m", OperatorCategory::CONVERSION, "Feet to meters (1 ft = 0.3048 m)"),
+    simple<centimetersToInches>("cm>in", OperatorCategory::CONVERSION, "Centimeters to inches (1 in = 2.54 cm)"),
+    simple<inchesToCentimeters>("in>cm", OperatorCategory::CONVERSION, "Inches to centimeters (1 in = 2.54 cm)"),
     // Weight/mass
-    registerUnaryOp("kg>lb", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 2.20462262; }, "Kilograms to pounds (1 kg = 2.20462262 lb)");
-    registerUnaryOp("lb>kg", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 2.20462262; }, "Pounds to kilograms (1 kg = 2.20462262 lb)");
-    registerUnaryOp("g>oz", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 28.3495231; }, "Grams to ounces (1 oz = 28.3495231 g)");
-    registerUnaryOp("oz>g", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 28.3495231; }, "Ounces to grams (1 oz = 28.3495231 g)");
+    simple<kilogramsToPounds>("kg>lb", OperatorCategory::CONVERSION, "Kilograms to pounds (1 kg = 2.20462262 lb)"),
+    simple<poundsToKilograms>("lb>kg", OperatorCategory::CONVERSION, "Pounds to kilograms (1 kg = 2.20462262 lb)"),
+    simple<gramsToOunces>("g>oz", OperatorCategory::CONVERSION, "Grams to ounces (1 oz = 28.3495231 g)"),
+    simple<ouncesToGrams>("oz>g", OperatorCategory::CONVERSION, "Ounces to grams (1 oz = 28.3495231 g)"),
     // Volume
-    registerUnaryOp("l>gal", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 3.78541178; }, "Liters to US gallons (1 gal = 3.78541178 L)");
-    registerUnaryOp("gal>l", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 3.78541178; }, "US gallons to liters (1 gal = 3.78541178 L)");
+    simple<litersToGallons>("l>gal", OperatorCategory::CONVERSION, "Liters to US gallons (1 gal = 3.78541178 L)"),
+    simple<gallonsToLiters>("gal>l", OperatorCategory::CONVERSION, "US gallons to liters (1 gal = 3.78541178 L)"),
     // Energy
-    registerUnaryOp("btu>kwh", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x / 3412.14163; }, "BTU to kilowatt-hours (1 kWh = 3412.14163 BTU)");
-    registerUnaryOp("kwh>btu", OperatorCategory::CONVERSION,
-        [](RPNCalculator&, double x) { return x * 3412.14163; }, "Kilowatt-hours to BTU (1 kWh = 3412.14163 BTU)");
-}
+    simple<btuToKilowattHours>("btu>kwh", OperatorCategory::CONVERSION, "BTU to kilowatt-hours (1 kWh = 3412.14163 BTU)"),
+    simple<kilowattHoursToBtu>("kwh>btu", OperatorCategory::CONVERSION, "Kilowatt-hours to BTU (1 kWh = 3412.14163 BTU)"),
+};
 
 // ============================================================================
 // MISCELLANEOUS OPERATORS
 // ============================================================================
-void OperatorRegistry::registerMiscellaneous() {
-    // TODO: Implement additional HP calculator features:
-    // - Percentage operations: %T (percent of total)
-    // - Statistical functions: Σ+ Σ- mean stddev linear regression
-    // - Display format: FIX SCI ENG for fixed/scientific/engineering notation
-    // - Quiet mode: option to not print after every operation
-    
+// TODO: Implement additional HP calculator features:
+// - Percentage operations: %T (percent of total)
+// - Statistical functions: Σ+ Σ- mean stddev linear regression
+// - Display format: FIX SCI ENG for fixed/scientific/engineering notation
+static double squareRoot(RPNCalculator&, double x) { return std::sqrt(x); }
+static double absolute(RPNCalculator&, double x) { return std::abs(x); }
+static double negate(RPNCalculator&, double x) { return -x; }
+static double square(RPNCalculator&, double x) { return x * x; }
+static double reciprocal(RPNCalculator&, double x) { return 1.0 / x; }
+static double gammaFunction(RPNCalculator&, double x) { return std::tgamma(x); }
+static double factorial(RPNCalculator&, double x) { return std::tgamma(x + 1); }
+static double roundDown(RPNCalculator&, double x) { return std::floor(x); }
+static double roundUp(RPNCalculator&, double x) { return std::ceil(x); }
+static double roundNearest(RPNCalculator&, double x) { return std::round(x); }
+static double roundTowardZero(RPNCalculator&, double x) { return std::trunc(x); }
+static bool negative(RPNCalculator&, double x) { return x < 0; }
+static bool zero(RPNCalculator&, double x) { return x == 0; }
+
+// Operators of one category with their descriptions
+static void printCategory(RPNCalculator& calc, OperatorCategory cat) {
+    auto reg = OperatorRegistry::instance().snapshot();
+    std::vector<std::string> names = reg->getNamesByCategory(cat);
+    std::sort(names.begin(), names.end());
+
+    calc.printStatus(OperatorRegistry::categoryName(cat) + " operators:");
+    for (const auto& name : names) {
+        const Operator* op = reg->getOperator(name);
+        if (op) {
+            calc.printStatus("  " + name + " - " + std::string(op->description));
+        }
+    }
+}
+
+template <OperatorCategory Cat>
+static void categoryHelp(RPNCalculator& calc, const Operator&) {
+    printCategory(calc, Cat);
+}
+
+static constexpr Operator kMiscellaneous[] = {
     // Square root
-    registerOperator({"sqrt", OperatorType::UNARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    {"sqrt", OperatorType::UNARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x < 0) {
             calc.printError("Error: Square root of negative number");
@@ -654,27 +731,23 @@ void OperatorRegistry::registerMiscellaneous() {
         double result = std::sqrt(x);
         calc.pushStack(result);
         calc.print(result);
-    }, "Square root"});
-    
-    registerUnaryOp("abs", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::abs(x); }, "Absolute value");
-    registerUnaryOp("neg", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return -x; }, "Negation");
-    registerUnaryOp("chs", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return -x; }, "Change sign (alias for neg)");
-    
+    }, "Square root", checkedKernel<squareRoot, negative>},
+
+    simple<absolute>("abs", OperatorCategory::MISCELLANEOUS, "Absolute value"),
+    simple<negate>("neg", OperatorCategory::MISCELLANEOUS, "Negation"),
+    simple<negate>("chs", OperatorCategory::MISCELLANEOUS, "Change sign (alias for neg)"),
+
     // Square (x^2)
-    registerUnaryOp("sq", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return x * x; }, "Square (x^2)");
-    
+    simple<square>("sq", OperatorCategory::MISCELLANEOUS, "Square (x^2)"),
+
     // LASTX - recall last X value before operation
-    registerOperator({"lastx", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    {"lastx", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         calc.pushStack(calc.lastX_);
         calc.print(calc.lastX_);
-    }, "Recall last X (last displayed value before an operation)"});
-    
+    }, "Recall last X (last displayed value before an operation)"},
+
     // Inverse (1/x)
-    registerOperator({"inv", OperatorType::UNARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    {"inv", OperatorType::UNARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         double x = calc.popStack();
         if (x == 0) {
             calc.printError("Error: Division by zero");
@@ -684,153 +757,129 @@ void OperatorRegistry::registerMiscellaneous() {
         double result = 1.0 / x;
         calc.pushStack(result);
         calc.print(result);
-    }, "Inverse (1/x)"});
-    
-    registerGuardedUnaryOp("gamma", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::tgamma(x); }, "Gamma function");
-    registerGuardedUnaryOp("!", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::tgamma(x + 1); }, "Factorial");
-    registerUnaryOp("floor", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::floor(x); }, "Floor (round down)");
-    registerUnaryOp("ceil", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::ceil(x); }, "Ceiling (round up)");
-    registerUnaryOp("round", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::round(x); }, "Round to nearest integer");
-    registerUnaryOp("trunc", OperatorCategory::MISCELLANEOUS,
-        [](RPNCalculator&, double x) { return std::trunc(x); }, "Truncate (round toward zero)");
-    
+    }, "Inverse (1/x)", checkedKernel<reciprocal, zero>},
+
+    guarded<gammaFunction>("gamma", OperatorCategory::MISCELLANEOUS, "Gamma function"),
+    guarded<factorial>("!", OperatorCategory::MISCELLANEOUS, "Factorial"),
+    simple<roundDown>("floor", OperatorCategory::MISCELLANEOUS, "Floor (round down)"),
+    simple<roundUp>("ceil", OperatorCategory::MISCELLANEOUS, "Ceiling (round up)"),
+    simple<roundNearest>("round", OperatorCategory::MISCELLANEOUS, "Round to nearest integer"),
+    simple<roundTowardZero>("trunc", OperatorCategory::MISCELLANEOUS, "Truncate (round toward zero)"),
+
     // Constants
-    registerOperator({"pi", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    {"pi", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         calc.pushStack(M_PI);
         calc.print(M_PI);
-    }, "Push pi (3.14159...)"});
-    
-    registerOperator({"e", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    }, "Push pi (3.14159...)"},
+
+    {"e", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         calc.pushStack(M_E);
         calc.print(M_E);
-    }, "Push e (2.71828...)"});
-    
-    registerOperator({"phi", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    }, "Push e (2.71828...)"},
+
+    {"phi", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         double phi = (1.0 + std::sqrt(5.0)) / 2.0;  // Golden ratio
         calc.pushStack(phi);
         calc.print(phi);
-    }, "Push phi golden ratio (1.61803...)"});
-    
+    }, "Push phi golden ratio (1.61803...)"},
+
     // Angle mode commands
-    registerOperator({"deg", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    {"deg", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         calc.setAngleMode("degrees");
         calc.printStatus("Angle mode: degrees");
-    }, "Set degrees mode"});
-    
-    registerOperator({"rad", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    }, "Set degrees mode"},
+
+    {"rad", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         calc.setAngleMode("radians");
         calc.printStatus("Angle mode: radians");
-    }, "Set radians mode"});
-    
-    registerOperator({"grd", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+    }, "Set radians mode"},
+
+    {"grd", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         calc.setAngleMode("gradians");
         calc.printStatus("Angle mode: gradians");
-    }, "Set gradians mode"});
-    
+    }, "Set gradians mode"},
+
     // Help command - shows operators grouped by category
-    registerOperator({"help", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator&) {
-        OperatorRegistry& reg = OperatorRegistry::instance();
-        
+    {"help", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
+        auto reg = OperatorRegistry::instance().snapshot();
+
         // Show operators grouped by category
-        for (OperatorCategory cat : reg.allCategories()) {
-            std::vector<std::string> names = reg.getNamesByCategory(cat);
+        for (OperatorCategory cat : OperatorRegistry::allCategories()) {
+            std::vector<std::string> names = reg->getNamesByCategory(cat);
             if (names.empty()) continue;
-            
+
             std::sort(names.begin(), names.end());
-            std::cout << "\n" << reg.categoryName(cat) << ":" << std::endl;
+            calc.printStatus("\n" + OperatorRegistry::categoryName(cat) + ":");
             for (const auto& name : names) {
-                const Operator* op = reg.getOperator(name);
+                const Operator* op = reg->getOperator(name);
                 if (op) {
-                    std::cout << "  " << name << " - " << op->description << std::endl;
+                    calc.printStatus("  " + name + " - " + std::string(op->description));
                 }
             }
         }
-        std::cout << "\nVariables:" << std::endl;
-        std::cout << "  name= - Store top of stack to variable 'name'" << std::endl;
-        std::cout << "  name  - Recall variable 'name' (must not shadow operator)" << std::endl;
-        std::cout << "  x,y,z,t - Auto-bound to top 4 stack positions (when autobind enabled)" << std::endl;
-        std::cout << "\nUser-defined operators:" << std::endl;
-        std::cout << "  name{ - Define operator (saved to ~/.rpn)" << std::endl;
-        std::cout << "  name[ - Define temporary operator (session only)" << std::endl;
-        std::cout << "  }     - End definition" << std::endl;
-        std::cout << "  ]     - End definition" << std::endl;
-        std::cout << "  name  - Execute operator (temporary or saved)" << std::endl;
-        std::cout << "  name@ - Execute operator (backward compatibility)" << std::endl;
-        std::cout << "\nSpecial commands: show, fix, fmt, autobind, q/quit/exit" << std::endl;
-        std::cout << "  show/config - Display current configuration settings" << std::endl;
-        std::cout << "  fix - Set decimal places (0-15, requires value on stack)" << std::endl;
-        std::cout << "  fmt - Toggle locale number formatting" << std::endl;
-        std::cout << "  autobind - Toggle x,y,z,t auto-binding (on by default)" << std::endl;
-        std::cout << "\nTiered help: help_<category>" << std::endl;
-        std::cout << "  help_arith, help_trig, help_hyper, help_log, help_stack, help_conv, help_misc, help_user" << std::endl;
-    }, "Show this help"});
-    
-    registerOperator({"?", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
+        calc.printStatus("\nVariables:");
+        calc.printStatus("  name= - Store top of stack to variable 'name'");
+        calc.printStatus("  name  - Recall variable 'name' (must not shadow operator)");
+        calc.printStatus("  x,y,z,t - Auto-bound to top 4 stack positions (when autobind enabled)");
+        calc.printStatus("\nUser-defined operators:");
+        calc.printStatus("  name{ - Define operator (saved to ~/.rpn)");
+        calc.printStatus("  name[ - Define temporary operator (session only)");
+        calc.printStatus("  }     - End definition");
+        calc.printStatus("  ]     - End definition");
+        calc.printStatus("  name  - Execute operator (temporary or saved)");
+        calc.printStatus("  name@ - Execute operator (backward compatibility)");
+        calc.printStatus("\nControl flow (in operator bodies; a condition of 0 is false):");
+        calc.printStatus("  cond if ... else ... then - Run one branch (else is optional)");
+        calc.printStatus("  n times ... loop - Run the body n times");
+        calc.printStatus("  begin ... cond while ... repeat - Run the body while cond is true");
+        calc.printStatus("\nArrays:");
+        calc.printStatus("  <file - Push the numbers in file (separated by blanks or commas) as an array");
+        calc.printStatus("  Element-wise operators apply to every element; scalars are repeated");
+        calc.printStatus("\nSpecial commands: show, fix, fmt, autobind, quiet, quietops, q/quit/exit");
+        calc.printStatus("  show/config - Display current configuration settings");
+        calc.printStatus("  fix - Set decimal places (0-15, requires value on stack)");
+        calc.printStatus("  fmt - Toggle locale number formatting");
+        calc.printStatus("  autobind - Toggle x,y,z,t auto-binding (on by default)");
+        calc.printStatus("  quiet - Toggle quiet mode (only show the final result of each line)");
+        calc.printStatus("  quietops - Toggle quiet operator bodies (only show each operator's result)");
+        calc.printStatus("\nTiered help: help_<category>");
+        calc.printStatus("  help_arith, help_cmp, help_trig, help_hyper, help_log, help_stack, help_conv, help_misc, help_array, help_user");
+    }, "Show this help"},
+
+    {"?", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
         // Alias for help
-        const Operator* helpOp = OperatorRegistry::instance().getOperator("help");
-        if (helpOp) helpOp->execute(calc);
-    }, "Show help (alias for help)"});
-    
-    // Helper for category-specific help
-    auto categoryHelp = [](OperatorCategory cat) {
-        OperatorRegistry& reg = OperatorRegistry::instance();
-        std::vector<std::string> names = reg.getNamesByCategory(cat);
-        std::sort(names.begin(), names.end());
-        
-        std::cout << reg.categoryName(cat) << " operators:" << std::endl;
-        for (const auto& name : names) {
-            const Operator* op = reg.getOperator(name);
-            if (op) {
-                std::cout << "  " << name << " - " << op->description << std::endl;
-            }
-        }
-    };
-    
+        const Operator* helpOp = findBuiltin("help");
+        helpOp->execute(calc, *helpOp);
+    }, "Show help (alias for help)"},
+
     // Tiered help commands
-    registerOperator({"help_arith", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::ARITHMETIC);
-    }, "Help for arithmetic operators"});
-    
-    registerOperator({"help_trig", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::TRIGONOMETRIC);
-    }, "Help for trigonometric operators"});
-    
-    registerOperator({"help_hyper", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::HYPERBOLIC);
-    }, "Help for hyperbolic operators"});
-    
-    registerOperator({"help_log", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::LOGARITHMIC);
-    }, "Help for logarithmic operators"});
-    
-    registerOperator({"help_stack", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::STACK);
-    }, "Help for stack operators"});
-    
-    registerOperator({"help_conv", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::CONVERSION);
-    }, "Help for unit conversion operators"});
-    
-    registerOperator({"help_misc", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::MISCELLANEOUS);
-    }, "Help for miscellaneous operators"});
-
-    registerOperator({"help_user", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [categoryHelp](RPNCalculator&) {
-        categoryHelp(OperatorCategory::USER);
-    }, "Help for user-defined operators"});
-    
+    {"help_arith", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::ARITHMETIC>, "Help for arithmetic operators"},
+    {"help_cmp", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::COMPARISON>, "Help for comparison operators"},
+    {"help_trig", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::TRIGONOMETRIC>, "Help for trigonometric operators"},
+    {"help_hyper", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::HYPERBOLIC>, "Help for hyperbolic operators"},
+    {"help_log", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::LOGARITHMIC>, "Help for logarithmic operators"},
+    {"help_stack", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::STACK>, "Help for stack operators"},
+    {"help_conv", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::CONVERSION>, "Help for unit conversion operators"},
+    {"help_misc", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::MISCELLANEOUS>, "Help for miscellaneous operators"},
+    {"help_array", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::ARRAY>, "Help for array operators"},
+    {"help_user", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS,
+        categoryHelp<OperatorCategory::USER>, "Help for user-defined operators"},
+
     // Random number generator (0 to 1 with precision matching scale)
-    registerOperator({"rand", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc) {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        
+    {"rand", OperatorType::NULLARY, OperatorCategory::MISCELLANEOUS, [](RPNCalculator& calc, const Operator&) {
+        static thread_local std::mt19937 gen(std::random_device{}());
+
         int scale = calc.getScale();
-        
+
         if (scale == 0) {
             // For scale 0, return 0 or 1
             std::uniform_int_distribution<> dis(0, 1);
@@ -848,5 +897,394 @@ void OperatorRegistry::registerMiscellaneous() {
             calc.pushStack(result);
             calc.print(result);
         }
-    }, "Random number [0,1] with precision matching scale setting"});
+    }, "Random number [0,1] with precision matching scale setting"},
+};
+
+// ============================================================================
+// ARRAY OPERATIONS
+// ============================================================================
+static constexpr Operator kArrays[] = {
+    // Start to end in steps of 1 (or -1)
+    {"range", OperatorType::BINARY, OperatorCategory::ARRAY, [](RPNCalculator& calc, const Operator&) {
+        const double kMaxElements = 1 << 26;
+        double end = calc.popStack();
+        double start = calc.popStack();
+        double span = std::floor(std::abs(end - start));
+        if (!std::isfinite(span) || span >= kMaxElements) {
+            calc.printError("Error: Range too large");
+            calc.pushStack(start);
+            calc.pushStack(end);
+            return;
+        }
+        double step = end < start ? -1.0 : 1.0;
+        std::vector<double> values(static_cast<size_t>(span) + 1);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = start + step * i;
+        }
+        double result = calc.makeArray(std::move(values));
+        calc.pushStack(result);
+        calc.print(result);
+    }, "Array from y to x in steps of 1 (1 5 range -> [1 2 3 4 5])"},
+
+    {"pack", OperatorType::NULLARY, OperatorCategory::ARRAY, [](RPNCalculator& calc, const Operator&) {
+        std::vector<double> values = drainStack(calc);
+        std::reverse(values.begin(), values.end());  // Bottom of the stack first
+        double result = calc.makeArray(std::move(values));
+        calc.pushStack(result);
+        calc.print(result);
+    }, "Collect the whole stack into one array (bottom first)"},
+
+    {"unpack", OperatorType::NULLARY, OperatorCategory::ARRAY, [](RPNCalculator& calc, const Operator&) {
+        const std::vector<double>* values = calc.getArray(calc.peekStack());
+        if (!values) return;  // A scalar is its own only element
+        calc.popStack();
+        for (double value : *values) {
+            calc.pushStack(value);
+        }
+        if (!values->empty()) {
+            calc.print(values->back());
+        }
+    }, "Push the elements of an array"},
+
+    {"len", OperatorType::NULLARY, OperatorCategory::ARRAY, [](RPNCalculator& calc, const Operator&) {
+        const std::vector<double>* values = calc.getArray(calc.popStack());
+        double result = values ? values->size() : 1;
+        calc.pushStack(result);
+        calc.print(result);
+    }, "Number of elements (1 for a scalar)"},
+};
+
+// ============================================================================
+// BUILT-IN TABLE
+// ============================================================================
+
+template <size_t... N>
+static constexpr std::array<Operator, (N + ...)> concatenate(const Operator (&... tables)[N]) {
+    std::array<Operator, (N + ...)> all{};
+    size_t next = 0;
+    auto append = [&](const auto& table) {
+        for (const Operator& op : table) all[next++] = op;
+    };
+    (append(tables), ...);
+    return all;
+}
+
+static constexpr auto kBuiltins = concatenate(kArithmetic, kComparison, kTrigonometric, kHyperbolic,
+                                              kLogarithmic, kStack, kConversions, kMiscellaneous, kArrays);
+
+// Perfect hash of the built-in names: a seeded FNV-1a whose seed is searched
+// for at compile time until every name lands in a slot of its own.  A lookup
+// is one hash, one slot load and one name comparison.
+static constexpr size_t kHashSlots = 1024;  // ~11 per name, so a few dozen seeds suffice
+static constexpr std::uint32_t kMaxSeeds = 100000;
+static_assert(kBuiltins.size() < 256, "Slots hold 8-bit table indices");
+
+static constexpr std::uint32_t hashName(std::string_view name, std::uint32_t seed) {
+    std::uint32_t h = 2166136261u ^ seed;
+    for (char c : name) {
+        h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    h ^= h >> 15;  // Fold the well-mixed high bits into the slot bits
+    return h;
+}
+
+struct PerfectHash {
+    std::uint32_t seed = 0;
+    std::uint8_t slots[kHashSlots] = {};  // Table index + 1 (0 = empty)
+};
+
+static constexpr bool hasDuplicateNames() {
+    for (size_t i = 0; i < kBuiltins.size(); ++i) {
+        for (size_t j = i + 1; j < kBuiltins.size(); ++j) {
+            if (kBuiltins[i].name == kBuiltins[j].name) return true;
+        }
+    }
+    return false;
+}
+static_assert(!hasDuplicateNames(), "Duplicate built-in operator name");
+
+static constexpr PerfectHash buildPerfectHash() {
+    PerfectHash hash;
+    for (hash.seed = 0; hash.seed < kMaxSeeds; ++hash.seed) {
+        for (auto& slot : hash.slots) slot = 0;
+        bool collided = false;
+        for (size_t i = 0; i < kBuiltins.size() && !collided; ++i) {
+            std::uint8_t& slot = hash.slots[hashName(kBuiltins[i].name, hash.seed) & (kHashSlots - 1)];
+            collided = slot != 0;
+            slot = static_cast<std::uint8_t>(i + 1);
+        }
+        if (!collided) break;
+    }
+    return hash;
+}
+
+static constexpr PerfectHash kBuiltinHash = buildPerfectHash();
+static_assert(kBuiltinHash.seed < kMaxSeeds, "No perfect hash seed found; increase kHashSlots");
+
+const Operator* findBuiltin(std::string_view name) {
+    std::uint8_t slot = kBuiltinHash.slots[hashName(name, kBuiltinHash.seed) & (kHashSlots - 1)];
+    if (slot == 0) return nullptr;
+    const Operator& op = kBuiltins[slot - 1];
+    return op.name == name ? &op : nullptr;
+}
+
+// ============================================================================
+// REGISTRY
+// ============================================================================
+
+// Singleton instance
+OperatorRegistry& OperatorRegistry::instance() {
+    static OperatorRegistry registry;
+    return registry;
+}
+
+OperatorRegistry::OperatorRegistry() {
+    // The first snapshot has no user-defined operators, only the built-ins' names
+    Batch batch(*this);
+    edit();
+}
+
+// ============================================================================
+// SNAPSHOT PUBLICATION
+// ============================================================================
+
+OperatorRegistry::Batch::Batch(OperatorRegistry& registry)
+    : registry_(registry), lock_(registry.writeMutex_) {
+    registry_.batchDepth_++;
+}
+
+OperatorRegistry::Batch::~Batch() {
+    if (--registry_.batchDepth_ == 0 && registry_.draft_) {
+        registry_.publish();
+    }
+}
+
+// Called with writeMutex_ held
+RegistrySnapshot& OperatorRegistry::edit() {
+    if (!draft_) {
+        auto current = std::atomic_load(&current_);
+        draft_ = current ? std::make_shared<RegistrySnapshot>(*current)
+                         : std::make_shared<RegistrySnapshot>();
+    }
+    return *draft_;
+}
+
+// Called with writeMutex_ held
+void OperatorRegistry::publish() {
+    draft_->version_ = version_.load(std::memory_order_relaxed) + 1;
+    if (draft_->namesChanged_) {
+        std::vector<std::string> names;
+        names.reserve(draft_->count_);
+        for (const auto& page : draft_->pages_) {
+            if (!page) continue;
+            for (const auto& entry : *page) {
+                if (entry) names.push_back(entry->name);
+            }
+        }
+        draft_->userNames_ = std::make_shared<SuffixIndex>(std::move(names));
+        draft_->namesChanged_ = false;
+    }
+    std::shared_ptr<const RegistrySnapshot> published = std::move(draft_);
+    std::atomic_store(&current_, published);
+    version_.store(published->version_, std::memory_order_release);
+}
+
+void OperatorRegistry::registerOperator(const Operator& op, std::shared_ptr<Program> program) {
+    auto entry = std::make_shared<UserOperator>();
+    entry->name = op.name;
+    entry->description = op.description;
+    entry->program = std::move(program);
+    entry->op = op;
+    entry->op.name = entry->name;
+    entry->op.description = entry->description;
+    entry->op.program = entry->program.get();
+
+    std::lock_guard<std::recursive_mutex> lock(writeMutex_);
+    SymbolId id = SymbolTable::instance().intern(entry->name);
+    edit().setUserOperator(id, std::move(entry));
+    if (batchDepth_ == 0) publish();
+}
+
+void OperatorRegistry::removeOperator(const std::string& name) {
+    std::lock_guard<std::recursive_mutex> lock(writeMutex_);
+    RegistrySnapshot& next = edit();
+    SymbolId id = SymbolTable::instance().find(name);
+    if (next.getUserOperator(id)) {
+        next.setUserOperator(id, nullptr);
+    }
+    if (batchDepth_ == 0) publish();
+}
+
+// Copies only the page holding id; the others stay shared
+void RegistrySnapshot::setUserOperator(SymbolId id, std::shared_ptr<const UserOperator> entry) {
+    size_t index = id / kPageSize;
+    if (index >= pages_.size()) {
+        pages_.resize(index + 1);
+    }
+    auto page = pages_[index] ? std::make_shared<Page>(*pages_[index]) : std::make_shared<Page>();
+    auto& slot = (*page)[id % kPageSize];
+    if (!slot != !entry) {
+        count_ += entry ? 1 : -1;
+        namesChanged_ = true;
+    }
+    slot = std::move(entry);
+    pages_[index] = std::move(page);
+}
+
+// ============================================================================
+// SNAPSHOT LOOKUP
+// ============================================================================
+
+const Operator* RegistrySnapshot::getOperator(std::string_view name) const {
+    if (const Operator* op = findBuiltin(name)) return op;
+    return getUserOperator(SymbolTable::instance().find(name));
+}
+
+std::vector<std::string> RegistrySnapshot::getAllNames() const {
+    std::vector<std::string> names;
+    names.reserve(kBuiltins.size() + count_);
+    for (const Operator& op : kBuiltins) {
+        names.emplace_back(op.name);
+    }
+    for (const auto& page : pages_) {
+        if (!page) continue;
+        for (const auto& entry : *page) {
+            if (entry) names.push_back(entry->name);
+        }
+    }
+    return names;
+}
+
+std::vector<std::string> RegistrySnapshot::getNamesByCategory(OperatorCategory category) const {
+    std::vector<std::string> names;
+    for (const Operator& op : kBuiltins) {
+        if (op.category == category) {
+            names.emplace_back(op.name);
+        }
+    }
+    for (const auto& page : pages_) {
+        if (!page) continue;
+        for (const auto& entry : *page) {
+            if (entry && entry->op.category == category) {
+                names.push_back(entry->name);
+            }
+        }
+    }
+    return names;
+}
+
+std::string OperatorRegistry::categoryName(OperatorCategory category) {
+    switch (category) {
+        case OperatorCategory::ARITHMETIC: return "Arithmetic";
+        case OperatorCategory::COMPARISON: return "Comparison";
+        case OperatorCategory::TRIGONOMETRIC: return "Trigonometric";
+        case OperatorCategory::HYPERBOLIC: return "Hyperbolic";
+        case OperatorCategory::LOGARITHMIC: return "Logarithmic";
+        case OperatorCategory::STACK: return "Stack";
+        case OperatorCategory::CONVERSION: return "Unit Conversion";
+        case OperatorCategory::MISCELLANEOUS: return "Miscellaneous";
+        case OperatorCategory::ARRAY: return "Array";
+        case OperatorCategory::USER: return "User-defined";
+    }
+    return "Unknown";
+}
+
+const std::vector<OperatorCategory>& OperatorRegistry::allCategories() {
+    static std::vector<OperatorCategory> categories = {
+        OperatorCategory::ARITHMETIC,
+        OperatorCategory::COMPARISON,
+        OperatorCategory::TRIGONOMETRIC,
+        OperatorCategory::HYPERBOLIC,
+        OperatorCategory::LOGARITHMIC,
+        OperatorCategory::STACK,
+        OperatorCategory::CONVERSION,
+        OperatorCategory::MISCELLANEOUS,
+        OperatorCategory::ARRAY,
+        OperatorCategory::USER
+    };
+    return categories;
+}
+
+// ============================================================================
+// SUFFIX MATCHING
+// ============================================================================
+
+SuffixIndex::SuffixIndex(std::vector<std::string> names) : names_(std::move(names)), trie_(1) {
+    // Insert each name last character first
+    for (size_t i = 0; i < names_.size(); ++i) {
+        const std::string& name = names_[i];
+        std::uint32_t node = 0;
+        for (auto c = name.rbegin(); c != name.rend(); ++c) {
+            auto& children = trie_[node].children;
+            auto edge = std::find_if(children.begin(), children.end(),
+                                     [c](const std::pair<char, std::uint32_t>& e) { return e.first == *c; });
+            if (edge != children.end()) {
+                node = edge->second;
+            } else {
+                std::uint32_t child = static_cast<std::uint32_t>(trie_.size());
+                children.emplace_back(*c, child);
+                trie_.emplace_back();
+                node = child;
+            }
+        }
+        trie_[node].name = static_cast<int>(i);
+    }
+}
+
+std::string_view SuffixIndex::findLongestSuffix(std::string_view token, size_t& opStart) const {
+    std::string_view match;
+    std::uint32_t node = 0;
+    for (size_t i = token.size(); i > 0; --i) {
+        const auto& children = trie_[node].children;
+        char c = token[i - 1];
+        auto edge = std::find_if(children.begin(), children.end(),
+                                 [c](const std::pair<char, std::uint32_t>& e) { return e.first == c; });
+        if (edge == children.end()) break;
+        node = edge->second;
+        if (trie_[node].name >= 0) {
+            match = names_[trie_[node].name];
+            opStart = i - 1;
+        }
+    }
+    return match;
+}
+
+static const SuffixIndex& builtinSuffixes() {
+    static const SuffixIndex index([] {
+        std::vector<std::string> names;
+        for (const Operator& op : kBuiltins) {
+            names.emplace_back(op.name);
+        }
+        return names;
+    }());
+    return index;
+}
+
+// User-defined names cannot shadow built-ins, so the longer match wins
+std::string_view RegistrySnapshot::findLongestSuffix(std::string_view token, size_t& opStart) const {
+    std::string_view match = builtinSuffixes().findLongestSuffix(token, opStart);
+    size_t userStart;
+    std::string_view user = userNames_->findLongestSuffix(token, userStart);
+    if (user.size() > match.size()) {
+        opStart = userStart;
+        return user;
+    }
+    return match;
+}
+
+void OperatorRegistry::setBuiltinCompletions(const std::vector<std::string>& builtins) {
+    builtins_ = builtins;
+    completions_version_ = 0;
+}
+
+const std::vector<std::string>& OperatorRegistry::completions() {
+    if (completions_version_ != version()) {
+        completions_cache_ = snapshot()->getAllNames();
+        // add builtins not in registry
+        completions_cache_.insert(completions_cache_.end(), builtins_.begin(), builtins_.end());
+        std::sort(completions_cache_.begin(), completions_cache_.end());
+        completions_cache_.erase(std::unique(completions_cache_.begin(), completions_cache_.end()), completions_cache_.end());
+        completions_version_ = version();
+    }
+    return completions_cache_;
 }
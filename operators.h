@@ -17,11 +17,17 @@
 #define OPERATORS_H
 
 #include <string>
-#include <functional>
+#include <string_view>
 #include <unordered_map>
-#include <stack>
 #include <vector>
 #include <optional>
+#include <memory>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "bytecode.h"
+#include "symbols.h"
 
 // Forward declaration
 class RPNCalculator;
@@ -36,86 +42,176 @@ enum class OperatorType {
 // Operator categories for help organization
 enum class OperatorCategory {
     ARITHMETIC,
+    COMPARISON,
     TRIGONOMETRIC,
     HYPERBOLIC,
     LOGARITHMIC,
     STACK,
     CONVERSION,
     MISCELLANEOUS,
+    ARRAY,
     USER
 };
 
-// Operator definition
+// Operator definition.  A literal type: built-in operators are a constant
+// table (operators.cpp), and user-defined ones point into a UserOperator.
 struct Operator {
+    using Execute = void (*)(RPNCalculator& calc, const Operator& op);
+
+    // Element-wise form for columnar evaluation (csv.cpp): out[i] = op(y[i], x[i]),
+    // with y null for unary operators; out may alias x or y.  Rows whose scalar
+    // form would report an error are flagged in fallback[i] and left for
+    // execute to redo.
+    using Kernel = void (*)(RPNCalculator& calc, const double* y, const double* x,
+                            double* out, unsigned char* fallback, size_t n);
+
+    // The arithmetic alone, for operators whose scalar form cannot fail
+    // (y is ignored by unary ones).  The bytecode VM applies it to the stack
+    // itself instead of calling execute.
+    using Scalar = double (*)(RPNCalculator& calc, double y, double x);
+
+    std::string_view name;
+    OperatorType type = OperatorType::NULLARY;
+    OperatorCategory category = OperatorCategory::USER;
+    Execute execute = nullptr;
+    std::string_view description;
+    Kernel kernel = nullptr;     // Unset: not vectorizable
+    Scalar scalar = nullptr;     // Unset: the VM calls execute
+    Program* program = nullptr;  // Compiled body (user-defined operators only)
+};
+
+// Built-in operator named name, or nullptr.  Built-ins live in a constant
+// table indexed by a perfect hash of their names, so they cost nothing at
+// startup and are never copied into registry snapshots.
+const Operator* findBuiltin(std::string_view name);
+
+// A user-defined operator, owning the strings and body its Operator refers to
+// (hence not copyable)
+struct UserOperator {
+    UserOperator() = default;
+    UserOperator(const UserOperator&) = delete;
+    UserOperator& operator=(const UserOperator&) = delete;
+
     std::string name;
-    OperatorType type;
-    OperatorCategory category;
-    std::function<void(RPNCalculator&)> execute;
     std::string description;
+    std::shared_ptr<Program> program;
+    Operator op;
+};
+
+// Longest name in a set that is a suffix of a token, found by walking the
+// token backwards through a trie of the reversed names.  Immutable once built.
+class SuffixIndex {
+public:
+    explicit SuffixIndex(std::vector<std::string> names);
+    // Empty if no name matches; opStart is only set on a match
+    std::string_view findLongestSuffix(std::string_view token, size_t& opStart) const;
+
+private:
+    std::vector<std::string> names_;
+    struct Node {
+        std::vector<std::pair<char, std::uint32_t>> children;  // char -> node index
+        int name = -1;  // Index into names_ of a name ending here
+    };
+    std::vector<Node> trie_;
 };
 
-// Operator registry - makes it easy to add new operators
+// Immutable view of the operator set: the built-ins plus an overlay of
+// user-defined operators.  Published snapshots are never modified, so any
+// number of threads can read one without locking; Operator pointers obtained
+// from a snapshot stay valid while it is held.
+class RegistrySnapshot {
+public:
+    // User-defined operators only; built-in names are never looked up by ID
+    const Operator* getUserOperator(SymbolId id) const {
+        if (id / kPageSize >= pages_.size() || !pages_[id / kPageSize]) return nullptr;
+        const auto& entry = (*pages_[id / kPageSize])[id % kPageSize];
+        return entry ? &entry->op : nullptr;
+    }
+    const Operator* getOperator(std::string_view name) const;
+    bool hasOperator(std::string_view name) const { return getOperator(name) != nullptr; }
+
+    // Increases with every published change; compiled programs holding
+    // resolved Operator pointers are stale once it moves on
+    std::uint64_t version() const { return version_; }
+
+    // Get all operator names for help/extraction
+    std::vector<std::string> getAllNames() const;
+    std::vector<std::string> getNamesByCategory(OperatorCategory category) const;
+
+    // Longest operator name that is a suffix of token (empty if none)
+    std::string_view findLongestSuffix(std::string_view token, size_t& opStart) const;
+
+private:
+    friend class OperatorRegistry;
+
+    // User-defined operators by SymbolId, in pages that a new snapshot
+    // shares with the one it was copied from until it changes an entry
+    static constexpr size_t kPageSize = 64;
+    using Page = std::array<std::shared_ptr<const UserOperator>, kPageSize>;
+    std::vector<std::shared_ptr<const Page>> pages_;  // null = no operators
+    size_t count_ = 0;
+    std::uint64_t version_ = 0;
+    void setUserOperator(SymbolId id, std::shared_ptr<const UserOperator> entry);  // null removes
+
+    // Suffix index of the user-defined names (the built-ins have a static
+    // one).  Shared too, and only rebuilt when a name is added or removed.
+    std::shared_ptr<const SuffixIndex> userNames_;
+    bool namesChanged_ = true;  // Draft: userNames_ is out of date
+};
+
+// Operator registry for user-defined operators.  Changes are copy-on-write:
+// each one builds a new snapshot and publishes it atomically (RCU-style),
+// while readers keep using whichever snapshot they hold.
 class OperatorRegistry {
 public:
     static OperatorRegistry& instance();
     
-    void registerOperator(const Operator& op);
+    // Current snapshot (takes a reference; hold it rather than calling per lookup)
+    std::shared_ptr<const RegistrySnapshot> snapshot() const { return std::atomic_load(&current_); }
+    // Version of the current snapshot, cheap enough to poll
+    std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // Adds or replaces a user-defined operator: op with its name and
+    // description copied and program attached
+    void registerOperator(const Operator& op, std::shared_ptr<Program> program);
     void removeOperator(const std::string& name);
-    bool hasOperator(const std::string& name) const;
-    const Operator* getOperator(const std::string& name) const;
-    
-    // Get all operator names for help/extraction
-    std::vector<std::string> getAllNames() const;
-    std::vector<std::string> getNamesByCategory(OperatorCategory category) const;
+
+    // Groups changes into one published snapshot while in scope
+    class Batch {
+    public:
+        explicit Batch(OperatorRegistry& registry);
+        ~Batch();
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+    private:
+        OperatorRegistry& registry_;
+        std::lock_guard<std::recursive_mutex> lock_;
+    };
+
     static std::string categoryName(OperatorCategory category);
     static const std::vector<OperatorCategory>& allCategories();
 
-    // Cached names sorted by length (desc) for operator extraction
-    const std::vector<std::string>& getNamesSortedByLengthDesc();
-
-    // Readline completions management (encapsulates former global g_completions)
+    // Readline completions management (encapsulates former global g_completions);
+    // interactive thread only
     void setBuiltinCompletions(const std::vector<std::string>& builtins);
     const std::vector<std::string>& completions();
     
 private:
     OperatorRegistry();
-    std::unordered_map<std::string, Operator> operators_;
+    std::shared_ptr<const RegistrySnapshot> current_;  // Accessed with atomic_load/atomic_store
+    std::atomic<std::uint64_t> version_{0};
 
-    // Caches
-    bool names_len_desc_dirty_ = true;
-    std::vector<std::string> names_len_desc_cache_;
+    // Writer side: changes accumulate in draft_ until published
+    std::recursive_mutex writeMutex_;
+    std::shared_ptr<RegistrySnapshot> draft_;
+    int batchDepth_ = 0;
+    RegistrySnapshot& edit();
+    void publish();
 
     // Completions
-    bool completions_dirty_ = true;
+    std::uint64_t completions_version_ = 0;
     std::vector<std::string> builtins_;
     std::vector<std::string> completions_cache_;
-    
-    // Initialize all operators
-    void initializeOperators();
-    
-    // Helper to register operators by category
-    void registerArithmetic();
-    void registerTrigonometric();
-    void registerHyperbolic();
-    void registerLogarithmic();
-    void registerStackOperations();
-    void registerUnitConversions();
-    void registerMiscellaneous();
-
-    // Registration helpers to reduce boilerplate
-    using UnaryFn = std::function<double(RPNCalculator&, double)>;
-    using BinaryFn = std::function<double(RPNCalculator&, double, double)>;
-
-    // Simple: pop, compute, push, print
-    void registerUnaryOp(const std::string& name, OperatorCategory cat,
-                         UnaryFn fn, const std::string& desc);
-    void registerBinaryOp(const std::string& name, OperatorCategory cat,
-                          BinaryFn fn, const std::string& desc);
-    // Guarded: same as simple but checks NaN/infinity and restores operands on error
-    void registerGuardedUnaryOp(const std::string& name, OperatorCategory cat,
-                                UnaryFn fn, const std::string& desc);
-    void registerGuardedBinaryOp(const std::string& name, OperatorCategory cat,
-                                 BinaryFn fn, const std::string& desc);
 };
 
 #endif // OPERATORS_H
@@ -0,0 +1,51 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "output.h"
+#include <cstdio>
+
+// Singleton instance (there is only one stdout)
+StdioSink& StdioSink::instance() {
+    static StdioSink sink;
+    return sink;
+}
+
+StdioSink::StdioSink() {
+    buffer_.reserve(kFlushThreshold);
+}
+
+StdioSink::~StdioSink() {
+    flush();
+}
+
+void StdioSink::write(std::string_view text) {
+    buffer_.append(text.data(), text.size());
+    if (buffer_.size() >= kFlushThreshold) {
+        flush();
+    }
+}
+
+void StdioSink::writeError(std::string_view text) {
+    flush();
+    std::fwrite(text.data(), 1, text.size(), stderr);
+}
+
+void StdioSink::flush() {
+    if (!buffer_.empty()) {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+        buffer_.clear();
+    }
+    std::fflush(stdout);
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <string>
+#include <string_view>
+
+// Destination for calculator output.  Sinks may buffer normal output until
+// flush(); the calculator decides where the flush points are.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+    virtual void write(std::string_view text) = 0;       // Results and status
+    virtual void writeError(std::string_view text) = 0;  // Diagnostics
+    virtual void flush() {}
+};
+
+// Buffers stdout and writes it in large blocks.  Errors flush pending output
+// first and go to stderr unbuffered, so the two streams stay in order.
+class StdioSink : public OutputSink {
+public:
+    static StdioSink& instance();
+
+    void write(std::string_view text) override;
+    void writeError(std::string_view text) override;
+    void flush() override;
+
+private:
+    StdioSink();
+    ~StdioSink() override;
+
+    static constexpr size_t kFlushThreshold = 64 * 1024;
+    std::string buffer_;
+};
+
+// Collects output in memory, e.g. one chunk of a parallel batch that is
+// written out later in input order
+class BufferSink : public OutputSink {
+public:
+    void write(std::string_view text) override { out.append(text.data(), text.size()); }
+    void writeError(std::string_view text) override { err.append(text.data(), text.size()); }
+
+    std::string out;  // Results and status
+    std::string err;  // Diagnostics
+};
+
+// Sends everything to another sink's diagnostics, e.g. whatever a CSV row
+// prints while its result column is being computed
+class ErrorSink : public OutputSink {
+public:
+    explicit ErrorSink(OutputSink& target) : target_(target) {}
+    void write(std::string_view text) override { target_.writeError(text); }
+    void writeError(std::string_view text) override { target_.writeError(text); }
+
+private:
+    OutputSink& target_;
+};
+
+#endif // OUTPUT_H
@@ -0,0 +1,179 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "rpn.h"
+#include "operators.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// ============================================================================
+// OPERATOR PROFILING
+// ============================================================================
+
+static std::uint64_t profileClock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Slow path of operator dispatch, taken while arrays exist or profiling is on
+void RPNCalculator::callOperator(const Operator& op) {
+    if (!profiling_) {
+        if (!broadcast(op)) op.execute(*this, op);
+        return;
+    }
+
+    SymbolId id = SymbolTable::instance().intern(op.name);  // Built-in names are interned on first call
+    if (id >= profile_.size()) {
+        profile_.resize(id + 1);
+    }
+    ProfileEntry& entry = profile_[id];
+    entry.calls++;
+    entry.maxDepth = std::max(entry.maxDepth, callDepth_ + (op.program ? 1 : 0));
+    entry.active++;
+    profileFrames_.push_back({profileClock(), 0});
+
+    if (op.program) {
+        // Finished by endProfile when its activation returns
+        callUserOperator(*op.program, id);
+        return;
+    }
+    if (!liveArrays_ || !broadcast(op)) op.execute(*this, op);
+    endProfile(id);
+}
+
+void RPNCalculator::endProfile(SymbolId id) {
+    ProfileFrame frame = profileFrames_.back();
+    profileFrames_.pop_back();
+    std::uint64_t elapsed = profileClock() - frame.start;
+    ProfileEntry& done = profile_[id];  // The body may have grown profile_
+    done.active--;
+    if (done.active == 0) {
+        done.totalNs += elapsed;  // Outermost activation only, so recursion isn't counted twice
+    }
+    done.selfNs += elapsed - std::min(elapsed, frame.childNs);
+    if (!profileFrames_.empty()) {
+        profileFrames_.back().childNs += elapsed;
+    }
+}
+
+void RPNCalculator::setProfiling(bool enabled) {
+    profiling_ = enabled;
+}
+
+void RPNCalculator::mergeProfile(const RPNCalculator& other) {
+    if (other.profile_.size() > profile_.size()) {
+        profile_.resize(other.profile_.size());
+    }
+    for (size_t id = 0; id < other.profile_.size(); ++id) {
+        const ProfileEntry& from = other.profile_[id];
+        ProfileEntry& to = profile_[id];
+        to.calls += from.calls;
+        to.totalNs += from.totalNs;
+        to.selfNs += from.selfNs;
+        to.maxDepth = std::max(to.maxDepth, from.maxDepth);
+    }
+}
+
+// Profiled operators, most self time first
+std::vector<SymbolId> RPNCalculator::profiledOperators() const {
+    std::vector<SymbolId> ids;
+    for (size_t id = 0; id < profile_.size(); ++id) {
+        if (profile_[id].calls > 0) ids.push_back(static_cast<SymbolId>(id));
+    }
+    std::sort(ids.begin(), ids.end(), [&](SymbolId a, SymbolId b) {
+        return profile_[a].selfNs > profile_[b].selfNs;
+    });
+    return ids;
+}
+
+// Statement "prof" prints the table; "prof on", "prof off" and "prof reset"
+bool RPNCalculator::handleProfileCommand(std::string_view stmt) {
+    static const char* const kSpace = " \t\n\v\f\r";
+    size_t start = stmt.find_first_not_of(kSpace);
+    if (start == std::string_view::npos) return false;
+    size_t end = std::min(stmt.find_first_of(kSpace, start), stmt.size());
+    std::string word(stmt.substr(start, end - start));
+    std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+    if (word != "prof") return false;
+
+    size_t argStart = stmt.find_first_not_of(kSpace, end);
+    std::string arg;
+    if (argStart != std::string_view::npos) {
+        size_t argEnd = stmt.find_last_not_of(kSpace) + 1;
+        arg.assign(stmt.substr(argStart, argEnd - argStart));
+        std::transform(arg.begin(), arg.end(), arg.begin(), ::tolower);
+    }
+
+    if (arg == "on") {
+        profiling_ = true;
+        printStatus("Profiling: on");
+    } else if (arg == "off") {
+        profiling_ = false;
+        printStatus("Profiling: off");
+    } else if (arg == "reset") {
+        profile_.clear();
+        printStatus("Profile cleared");
+    } else if (!arg.empty()) {
+        printError("Error: Usage: prof [on|off|reset]");
+    } else {
+        printProfile();
+    }
+    return true;
+}
+
+void RPNCalculator::printProfile() {
+    std::vector<SymbolId> ids = profiledOperators();
+    if (ids.empty()) {
+        printStatus(profiling_ ? "No operator calls profiled yet" : "Profiling is off (prof on)");
+        return;
+    }
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-16s %10s %12s %12s %6s", "operator", "calls", "total ms", "self ms", "depth");
+    printStatus(line);
+    const SymbolTable& symbols = SymbolTable::instance();
+    for (SymbolId id : ids) {
+        const ProfileEntry& entry = profile_[id];
+        std::snprintf(line, sizeof(line), "%-16s %10llu %12.3f %12.3f %6d", symbols.name(id).c_str(),
+                      static_cast<unsigned long long>(entry.calls), entry.totalNs / 1e6, entry.selfNs / 1e6,
+                      entry.maxDepth);
+        printStatus(line);
+    }
+}
+
+void RPNCalculator::finishProfile() {
+    if (!profiling_) return;
+    std::string json = "{\"operators\": [";
+    const SymbolTable& symbols = SymbolTable::instance();
+    bool first = true;
+    for (SymbolId id : profiledOperators()) {
+        const ProfileEntry& entry = profile_[id];
+        std::string name;
+        for (char c : symbols.name(id)) {
+            if (c == '"' || c == '\\') name += '\\';
+            name += c;
+        }
+        char fields[160];
+        std::snprintf(fields, sizeof(fields), "\"calls\": %llu, \"total_ns\": %llu, \"self_ns\": %llu, \"max_depth\": %d}",
+                      static_cast<unsigned long long>(entry.calls), static_cast<unsigned long long>(entry.totalNs),
+                      static_cast<unsigned long long>(entry.selfNs), entry.maxDepth);
+        json += first ? "\n  " : ",\n  ";
+        json += "{\"name\": \"" + name + "\", " + fields;
+        first = false;
+    }
+    json += first ? "]}\n" : "\n]}\n";
+    out_->flush();
+    out_->writeError(json);
+}
@@ -14,8 +14,8 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "rpn.h"
+#include "array.h"
 #include "operators.h"
-#include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
@@ -23,7 +23,9 @@
 #include <vector>
 #include <algorithm>
 #include <cstdlib>
-#include <stdexcept>
+#include <cstring>
+#include <charconv>
+#include <optional>
 #include <locale>
 #include <clocale>
 #include <readline/readline.h>
@@ -33,34 +35,34 @@
 RPNCalculator::RPNCalculator()
     : lastX_(0.0), stackLiftEnabled_(true),
       angleMode_(AngleMode::RADIANS), scale_(15), callDepth_(0),
-      recordingName_(""),
-      isPlayingMacro_(false), definingOp_(""),
+      namedMacroCount_(0), recordingName_(""),
+      recordingControl_(0), macroDepth_(0), definingOp_(""), recordingFrame_(0), liveArrays_(0),
+      profiling_(false), deferCompile_(false), runningCalls_(false),
+      callStackBudget_(kDefaultCallStackMB << 20),
       decimalSeparator_('.'), thousandsSeparator_(','), localeFormatting_(true),
-      outputPrefix_("\t→ "), autobindXYZ_(true), currentToken_("") {
+      outputPrefix_("\t→ "), autobindXYZ_(true),
+      quiet_(false), quietPinned_(false), quietOperators_(false), resultPending_(false),
+      currentToken_(""),
+      out_(&StdioSink::instance()), streaming_(false), sharedRegistry_(false) {
+    registry_ = OperatorRegistry::instance().snapshot();
+    frames_.reserve(128);  // Shallow calls never allocate
+    calls_.reserve(128);
     detectLocaleSeparators();
 }
 
 // ============================================================================
 // STACK OPERATIONS
 // ============================================================================
-void RPNCalculator::pushStack(double value) {
-    stack_.push(value);
+void RPNCalculator::pickStack(size_t level) {
+    stack_.pick(level);
 }
 
-double RPNCalculator::popStack() {
-    if (stack_.empty()) {
-        return 0.0;
-    }
-    double value = stack_.top();
-    stack_.pop();
-    return value;
+void RPNCalculator::rollStack(size_t level) {
+    stack_.roll(level);
 }
 
-double RPNCalculator::peekStack() const {
-    if (stack_.empty()) {
-        return 0.0;
-    }
-    return stack_.top();
+void RPNCalculator::rollStackDown(size_t level) {
+    stack_.rollDown(level);
 }
 
 bool RPNCalculator::isStackEmpty() const {
@@ -72,12 +74,12 @@ size_t RPNCalculator::stackSize() const {
 }
 
 void RPNCalculator::clearStack() {
-    while (!stack_.empty()) {
-        stack_.pop();
-    }
+    stack_.clear();
 }
 
 void RPNCalculator::printStack() const {
+    resultPending_ = false;  // The stack display shows the result
+
     // Strip $op and $value placeholders from prefix for stack display
     std::string prefix = outputPrefix_;
     size_t pos = prefix.find("$op");
@@ -90,20 +92,14 @@ void RPNCalculator::printStack() const {
     }
     
     if (stack_.empty()) {
-        std::cout << prefix << "0" << std::endl;
+        out_->write(prefix);
+        out_->write("0\n");
         return;
     }
 
-    std::stack<double> temp = stack_;
-    std::stack<double> reverse;
-
-    while (!temp.empty()) {
-        reverse.push(temp.top());
-        temp.pop();
-    }
-
-    int level = reverse.size() - 1;
-    while (!reverse.empty()) {
+    size_t level = stack_.size();
+    for (double value : stack_) {
+        level--;
         std::string label;
         if (autobindXYZ_ && level == 0) {
             label = "x";
@@ -116,36 +112,16 @@ void RPNCalculator::printStack() const {
         } else {
             label = std::to_string(level);
         }
-        std::cout << prefix << label << ": " << formatNumber(reverse.top()) << std::endl;
-        reverse.pop();
-        level--;
+        out_->write(prefix);
+        out_->write(label);
+        out_->write(": ");
+        out_->write(formatNumber(value));
+        out_->write("\n");
     }
 }
 
 void RPNCalculator::removeTrailingZeros() {
-    if (stack_.empty()) return;
-    
-    std::vector<double> temp;
-    // Pop all elements into temp vector
-    while (!stack_.empty()) {
-        temp.push_back(stack_.top());
-        stack_.pop();
-    }
-    
-    // Find first non-zero from the end (which is bottom of stack)
-    size_t firstNonZero = 0;
-    for (size_t i = temp.size(); i > 0; --i) {
-        if (temp[i-1] != 0.0) {
-            firstNonZero = i;
-            break;
-        }
-    }
-    
-    // Push back non-zero elements (in reverse order to maintain stack order)
-    // If firstNonZero is 0, all elements were zero, so push nothing (empty stack)
-    for (size_t i = firstNonZero; i > 0; --i) {
-        stack_.push(temp[i-1]);
-    }
+    stack_.trimBottomZeros();
 }
 
 // ============================================================================
@@ -179,6 +155,11 @@ bool RPNCalculator::getAutobind() const {
     return autobindXYZ_;
 }
 
+void RPNCalculator::setQuiet(bool enabled) {
+    quiet_ = enabled;
+    quietPinned_ = true;
+}
+
 double RPNCalculator::toRadians(double angle) const {
     if (angleMode_ == AngleMode::DEGREES) {
         return angle * M_PI / 180.0;
@@ -217,141 +198,138 @@ double RPNCalculator::recallMemory(int location) const {
 // ============================================================================
 bool RPNCalculator::storeVariable(const std::string& name, double value) {
     // Check if name would shadow an operator
-    OperatorRegistry& registry = OperatorRegistry::instance();
-    if (registry.hasOperator(name)) {
+    if (registry_->hasOperator(name)) {
         return false;  // Cannot shadow operator
     }
-    // Also check built-in commands
+    // Also check built-in commands and control words
     if (name == "sto" || name == "rcl" || name == "scale" || name == "fmt" ||
-        name == "q" || name == "quit" || name == "exit") {
+        name == "quiet" || name == "quietops" ||
+        name == "q" || name == "quit" || name == "exit" || controlWord(name) != ControlWord::NONE) {
         return false;
     }
     // Prevent assignment to reserved operator-local variables (if autobind is enabled)
     if (autobindXYZ_ && (name == "x" || name == "y" || name == "z" || name == "t")) {
         return false;
     }
-    namedVariables_[name] = value;
+    bindVariable(SymbolTable::instance().intern(name), value);
     return true;
 }
 
 bool RPNCalculator::hasVariable(const std::string& name) const {
-    return namedVariables_.find(name) != namedVariables_.end();
+    if (autobindXYZ_ && findRegister(registerIndex(name))) {
+        return true;
+    }
+    return findVariable(SymbolTable::instance().find(name)) != nullptr;
 }
 
 double RPNCalculator::recallVariable(const std::string& name) const {
-    auto it = namedVariables_.find(name);
-    if (it != namedVariables_.end()) {
-        return it->second;
+    if (autobindXYZ_) {
+        if (const double* reg = findRegister(registerIndex(name))) {
+            return *reg;
+        }
     }
-    return 0.0;
+    const double* value = findVariable(SymbolTable::instance().find(name));
+    return value ? *value : 0.0;
+}
+
+void RPNCalculator::bindVariable(SymbolId id, double value) {
+    if (id >= variableValues_.size()) {
+        variableValues_.resize(id + 1, 0.0);
+        variableBound_.resize(id + 1, false);
+    }
+    variableValues_[id] = value;
+    variableBound_[id] = true;
+}
+
+RPNCalculator::Frame RPNCalculator::bindFrame() const {
+    // Registers past the stack depth keep the enclosing frame's values
+    Frame frame = frames_.empty() ? Frame{{0.0, 0.0, 0.0, 0.0}, 0u} : frames_.back();
+    size_t depth = std::min<size_t>(stack_.size(), 4);
+    for (size_t level = 0; level < depth; ++level) {
+        frame.registers[level] = stack_.peek(level);
+        frame.bound |= 1u << level;
+    }
+    return frame;
+}
+
+void RPNCalculator::endRecordingFrame() {
+    if (recordingFrame_ != 0 && recordingFrame_ == frames_.size()) {
+        frames_.pop_back();
+    }
+    recordingFrame_ = 0;
+}
+
+void RPNCalculator::refreshRegistry() {
+    heldRegistries_.clear();
+    OperatorRegistry& registry = OperatorRegistry::instance();
+    if (registry_->version() != registry.version()) {
+        registry_ = registry.snapshot();
+    }
+}
+
+void RPNCalculator::repinRegistry() {
+    heldRegistries_.push_back(std::move(registry_));
+    registry_ = OperatorRegistry::instance().snapshot();
+}
+
+int RPNCalculator::registerIndex(std::string_view name) {
+    if (name.size() != 1) return -1;
+    switch (name[0]) {
+        case 'x': return 0;
+        case 'y': return 1;
+        case 'z': return 2;
+        case 't': return 3;
+    }
+    return -1;
+}
+
+const double* RPNCalculator::findRegister(int index) const {
+    if (index < 0 || frames_.empty() || !(frames_.back().bound & (1u << index))) {
+        return nullptr;
+    }
+    return &frames_.back().registers[index];
 }
 
 // ============================================================================
 // TEMPORARY OPERATOR OPERATIONS
 // ============================================================================
 bool RPNCalculator::hasNamedMacro(const std::string& name) const {
-    return namedMacros_.find(name) != namedMacros_.end();
+    return getNamedMacro(name) != nullptr;
 }
 
 const std::vector<std::string>* RPNCalculator::getNamedMacro(const std::string& name) const {
-    auto it = namedMacros_.find(name);
-    if (it != namedMacros_.end()) {
-        return &it->second;
+    const MacroBody* macro = findMacro(SymbolTable::instance().find(name));
+    return macro ? &(*macro)->tokens : nullptr;
+}
+
+void RPNCalculator::defineMacro(const std::string& name, const std::vector<std::string>& tokens) {
+    SymbolId id = SymbolTable::instance().intern(name);
+    if (id >= namedMacros_.size()) {
+        namedMacros_.resize(id + 1);
     }
-    return nullptr;
+    if (!namedMacros_[id]) {
+        namedMacroCount_++;
+    }
+    // Compiled on first use, like an operator body
+    auto program = std::make_shared<Program>();
+    program->tokens = tokens;
+    namedMacros_[id] = std::move(program);
 }
 
 void RPNCalculator::executeMacro(const std::string& name) {
-    if (isPlayingMacro_) {
-        printError("Error: Nested temporary operator execution not supported");
-        return;
-    }
-    
-    const auto* macro = getNamedMacro(name);
+    const MacroBody* macro = findMacro(SymbolTable::instance().find(name));
     if (!macro) {
         printError("Error: No temporary operator named '" + name + "'");
         return;
     }
-    
-    isPlayingMacro_ = true;
-    
-    // Auto-bind x, y, z, t to top 4 stack positions (same as operators)
-    bool hadX = false, hadY = false, hadZ = false, hadT = false;
-    double oldX = 0.0, oldY = 0.0, oldZ = 0.0, oldT = 0.0;
-    
-    if (autobindXYZ_) {
-        // Save previous values if they exist
-        hadX = hasVariable("x");
-        hadY = hasVariable("y");
-        hadZ = hasVariable("z");
-        hadT = hasVariable("t");
-        oldX = hadX ? recallVariable("x") : 0.0;
-        oldY = hadY ? recallVariable("y") : 0.0;
-        oldZ = hadZ ? recallVariable("z") : 0.0;
-        oldT = hadT ? recallVariable("t") : 0.0;
-        
-        // Peek at top 4 values (x=top, y=second, z=third, t=fourth)
-        size_t size = stackSize();
-        if (size >= 1) {
-            double x = peekStack();
-            namedVariables_["x"] = x;
-        }
-        if (size >= 2) {
-            double topVal = popStack();
-            double y = peekStack();
-            pushStack(topVal);
-            namedVariables_["y"] = y;
-        }
-        if (size >= 3) {
-            double xVal = popStack();
-            double yVal = popStack();
-            double z = peekStack();
-            pushStack(yVal);
-            pushStack(xVal);
-            namedVariables_["z"] = z;
-        }
-        if (size >= 4) {
-            double xVal = popStack();
-            double yVal = popStack();
-            double zVal = popStack();
-            double t = peekStack();
-            pushStack(zVal);
-            pushStack(yVal);
-            pushStack(xVal);
-            namedVariables_["t"] = t;
-        }
-    }
-    
-            // Execute temporary operator body
-    for (const auto& t : *macro) {
-        processToken(t);
-    }
-    
-    // Restore previous x, y, z, t values (or remove if they didn't exist)
-    if (autobindXYZ_) {
-        if (hadX) {
-            namedVariables_["x"] = oldX;
-        } else {
-            namedVariables_.erase("x");
-        }
-        if (hadY) {
-            namedVariables_["y"] = oldY;
-        } else {
-            namedVariables_.erase("y");
-        }
-        if (hadZ) {
-            namedVariables_["z"] = oldZ;
-        } else {
-            namedVariables_.erase("z");
-        }
-        if (hadT) {
-            namedVariables_["t"] = oldT;
-        } else {
-            namedVariables_.erase("t");
-        }
-    }
-    
-    isPlayingMacro_ = false;
+    playMacro(*macro, name);
+}
+
+// Auto-binds x, y, z, t like an operator call; temporary operators may
+// call each other, to any depth the call stack budget allows
+void RPNCalculator::playMacro(MacroBody macro, std::string_view name) {
+    runningMacros_.push_back(std::move(macro));
+    enterCall(*runningMacros_.back(), CallKind::MACRO, name);
 }
 
 // ============================================================================
@@ -359,271 +337,159 @@ void RPNCalculator::executeMacro(const std::string& name) {
 // ============================================================================
 bool RPNCalculator::registerUserOperator(const std::string& name, const std::string& description,
                                           const std::vector<std::string>& tokens) {
-    OperatorRegistry& registry = OperatorRegistry::instance();
-    if (registry.hasOperator(name)) {
+    if (const Operator* existing = registry_->getOperator(name)) {
         // Allow re-registration of user-defined operators (overwrite)
-        const Operator* existing = registry.getOperator(name);
         if (existing->category != OperatorCategory::USER) {
             return false;  // Cannot shadow built-in operator
         }
     }
-    // Capture tokens by value in the lambda
-    std::vector<std::string> capturedTokens = tokens;
-    registry.registerOperator({name, OperatorType::NULLARY, OperatorCategory::USER,
-        [capturedTokens](RPNCalculator& calc) {
-            if (calc.callDepth_ >= 100) {
-                calc.printError("Error: Maximum recursion depth exceeded");
-                return;
-            }
-            calc.callDepth_++;
-            
-            // Auto-bind x, y, z, t to top 4 stack positions (non-destructive peek) if enabled
-            bool hadX = false, hadY = false, hadZ = false, hadT = false;
-            double oldX = 0.0, oldY = 0.0, oldZ = 0.0, oldT = 0.0;
-            
-            if (calc.autobindXYZ_) {
-                // Save previous values if they exist
-                hadX = calc.hasVariable("x");
-                hadY = calc.hasVariable("y");
-                hadZ = calc.hasVariable("z");
-                hadT = calc.hasVariable("t");
-                oldX = hadX ? calc.recallVariable("x") : 0.0;
-                oldY = hadY ? calc.recallVariable("y") : 0.0;
-                oldZ = hadZ ? calc.recallVariable("z") : 0.0;
-                oldT = hadT ? calc.recallVariable("t") : 0.0;
-                
-                // Peek at top 4 values (x=top, y=second, z=third, t=fourth)
-                size_t size = calc.stackSize();
-                if (size >= 1) {
-                    double x = calc.peekStack();
-                    calc.namedVariables_["x"] = x;
-                }
-                if (size >= 2) {
-                    double topVal = calc.popStack();
-                    double y = calc.peekStack();
-                    calc.pushStack(topVal);
-                    calc.namedVariables_["y"] = y;
-                }
-                if (size >= 3) {
-                    double xVal = calc.popStack();
-                    double yVal = calc.popStack();
-                    double z = calc.peekStack();
-                    calc.pushStack(yVal);
-                    calc.pushStack(xVal);
-                    calc.namedVariables_["z"] = z;
-                }
-                if (size >= 4) {
-                    double xVal = calc.popStack();
-                    double yVal = calc.popStack();
-                    double zVal = calc.popStack();
-                    double t = calc.peekStack();
-                    calc.pushStack(zVal);
-                    calc.pushStack(yVal);
-                    calc.pushStack(xVal);
-                    calc.namedVariables_["t"] = t;
-                }
-            }
-            
-            // Execute operator body
-            for (const auto& t : capturedTokens) {
-                calc.processToken(t);
-            }
-            
-            // Restore previous x, y, z, t values (or remove if they didn't exist)
-            if (calc.autobindXYZ_) {
-                if (hadX) {
-                    calc.namedVariables_["x"] = oldX;
-                } else {
-                    calc.namedVariables_.erase("x");
-                }
-                if (hadY) {
-                    calc.namedVariables_["y"] = oldY;
-                } else {
-                    calc.namedVariables_.erase("y");
-                }
-                if (hadZ) {
-                    calc.namedVariables_["z"] = oldZ;
-                } else {
-                    calc.namedVariables_.erase("z");
-                }
-                if (hadT) {
-                    calc.namedVariables_["t"] = oldT;
-                } else {
-                    calc.namedVariables_.erase("t");
-                }
-            }
-            
-            calc.callDepth_--;
-        }, description});
-    return true;
-}
-
-void RPNCalculator::saveUserOperator(const std::string& name, const std::string& description,
-                                      const std::vector<std::string>& tokens) {
-    const char* home = getenv("HOME");
-    if (!home) return;
-    std::string configPath = std::string(home) + "/.rpn";
-
-    // Read existing config, remove any previous definition of this operator
-    std::vector<std::string> lines;
-    std::ifstream inFile(configPath);
-    if (inFile.is_open()) {
-        std::string line;
-        while (std::getline(inFile, line)) {
-            // Skip existing definition of this operator
-            std::istringstream iss(line);
-            std::string cmd, existingName;
-            iss >> cmd >> existingName;
-            if (cmd == "operator" && existingName == name) continue;
-            lines.push_back(line);
-        }
-        inFile.close();
-    }
-
-    // Build the operator line: operator <name> <description> : <tokens...>
-    std::string opLine = "operator " + name + " " + description + " :";
-    for (const auto& t : tokens) {
-        opLine += " " + t;
-    }
-    lines.push_back(opLine);
-
-    // Write back atomically via temp file
-    std::string tempPath = configPath + ".tmp";
-    std::ofstream outFile(tempPath);
-    if (outFile.is_open()) {
-        for (const auto& l : lines) {
-            outFile << l << "\n";
-        }
-        outFile.close();
-        std::rename(tempPath.c_str(), configPath.c_str());
-    }
-}
-
-void RPNCalculator::deleteUserOperator(const std::string& name) {
-    const char* home = getenv("HOME");
-    if (!home) return;
-    std::string configPath = std::string(home) + "/.rpn";
-
-    std::vector<std::string> lines;
-    std::ifstream inFile(configPath);
-    if (inFile.is_open()) {
-        std::string line;
-        while (std::getline(inFile, line)) {
-            std::istringstream iss(line);
-            std::string cmd, existingName;
-            iss >> cmd >> existingName;
-            if (cmd == "operator" && existingName == name) continue;
-            lines.push_back(line);
-        }
-        inFile.close();
-    }
-
-    std::string tempPath = configPath + ".tmp";
-    std::ofstream outFile(tempPath);
-    if (outFile.is_open()) {
-        for (const auto& l : lines) {
-            outFile << l << "\n";
-        }
-        outFile.close();
-        std::rename(tempPath.c_str(), configPath.c_str());
+    // The body is compiled to bytecode once here (or after loadConfig has
+    // registered every operator) and recompiled only when the registry changes
+    auto program = std::make_shared<Program>();
+    program->tokens = tokens;
+    OperatorRegistry::instance().registerOperator({name, OperatorType::NULLARY, OperatorCategory::USER,
+        [](RPNCalculator& calc, const Operator& op) {
+            calc.callUserOperator(*op.program);
+        }, description}, program);
+    if (!deferCompile_) {
+        repinRegistry();
+        compileProgram(*program);
     }
+    return true;
 }
 
 // ============================================================================
 // OUTPUT OPERATIONS
 // ============================================================================
-std::string RPNCalculator::formatNumber(double value) const {
-    std::ostringstream oss;
-    oss << std::setprecision(scale_) << value;
-    std::string str = oss.str();
-
+// Formats with scale_ significant digits (the same output as the former
+// std::setprecision stream) using std::to_chars.  The result is written to
+// formatBuffer_, and locale separators are applied while copying digits out
+// of the scratch buffer, so no string is built.
+std::string_view RPNCalculator::formatNumber(double value) const {
+    if (isArrayHandle(value)) {
+        return formatArray(value);
+    }
     if (!localeFormatting_) {
-        return str;
+        auto result = std::to_chars(formatBuffer_, formatBuffer_ + sizeof(formatBuffer_),
+                                    value, std::chars_format::general, scale_);
+        return std::string_view(formatBuffer_, result.ptr - formatBuffer_);
     }
 
-    // Find the decimal point and exponent positions
-    size_t decimalPos = str.find('.');
-    size_t expPos = str.find('e');
-    if (expPos == std::string::npos) expPos = str.find('E');
-
-    // Determine the end of the integer part
-    size_t intEnd = (decimalPos != std::string::npos) ? decimalPos :
-                    (expPos != std::string::npos) ? expPos : str.length();
+    char raw[64];
+    auto result = std::to_chars(raw, raw + sizeof(raw), value, std::chars_format::general, scale_);
+    const char* p = raw;
+    const char* const end = result.ptr;
+    char* out = formatBuffer_;
 
-    // Find where digits start (after optional sign)
-    size_t intStart = 0;
-    if (!str.empty() && (str[0] == '-' || str[0] == '+')) {
-        intStart = 1;
+    // Copy sign if present
+    if (p < end && (*p == '-' || *p == '+')) {
+        *out++ = *p++;
     }
 
-    // Build the result with thousands separators in the integer part
-    std::string result;
-
-    // Add sign if present
-    if (intStart > 0) {
-        result += str[0];
+    // Integer part ends at the decimal point or exponent
+    const char* intEnd = p;
+    while (intEnd < end && *intEnd != '.' && *intEnd != 'e' && *intEnd != 'E') {
+        ++intEnd;
     }
 
-    // Add integer part with thousands separators
-    for (size_t i = intStart; i < intEnd; ++i) {
-        result += str[i];
-        size_t remaining = intEnd - i - 1;
+    // Integer part with thousands separators
+    for (; p < intEnd; ++p) {
+        *out++ = *p;
+        size_t remaining = intEnd - p - 1;
         if (remaining > 0 && remaining % 3 == 0) {
-            result += thousandsSeparator_;
+            *out++ = thousandsSeparator_;
         }
     }
 
-    // Add decimal part with locale decimal separator
-    if (decimalPos != std::string::npos) {
-        result += decimalSeparator_;
-        size_t fracEnd = (expPos != std::string::npos) ? expPos : str.length();
-        result += str.substr(decimalPos + 1, fracEnd - decimalPos - 1);
+    // Locale decimal separator, then fraction and exponent unchanged
+    if (p < end && *p == '.') {
+        *out++ = decimalSeparator_;
+        ++p;
     }
-
-    // Add exponent part unchanged
-    if (expPos != std::string::npos) {
-        result += str.substr(expPos);
+    while (p < end) {
+        *out++ = *p++;
     }
 
-    return result;
+    return std::string_view(formatBuffer_, out - formatBuffer_);
 }
 
-void RPNCalculator::print(double value) const {
-    std::string output = outputPrefix_;
-    std::string formattedValue = formatNumber(value);
-    
-    // Replace $op placeholder with current operator if present
-    size_t pos = output.find("$op");
-    if (pos != std::string::npos) {
-        // Don't show operator if it's a plain number (would duplicate the value)
-        std::string opText = "";
-        if (!currentToken_.empty() && !isNumber(currentToken_)) {
-            opText = currentToken_;
-        }
-        output.replace(pos, 3, opText);  // Replace "$op" with operator name
-    }
-    
-    // Replace $value placeholder with the formatted value
-    pos = output.find("$value");
-    if (pos != std::string::npos) {
-        output.replace(pos, 6, formattedValue);  // Replace "$value" with formatted number
-        std::cout << output << std::endl;
-    } else {
-        // No $value placeholder, append value at end (backward compatibility)
-        std::cout << output << formattedValue << std::endl;
-    }
+// The prefix is written in pieces around its placeholders, so nothing is
+// allocated per value
+void RPNCalculator::writeValue(double value) const {
+    // Don't show operator if it's a plain number (would duplicate the value)
+    std::string_view opText;
+    if (!currentToken_.empty() && !isNumber(currentToken_)) {
+        opText = currentToken_;
+    }
+    std::string_view formattedValue = formatNumber(value);
+
+    // Replace $op with the current operator and $value with the formatted value
+    struct Placeholder {
+        size_t at;
+        size_t length;
+        std::string_view text;
+    };
+    std::string_view prefix = outputPrefix_;
+    Placeholder first{prefix.find("$op"), 3, opText};
+    Placeholder second{prefix.find("$value"), 6, formattedValue};
+    bool hasValue = second.at != std::string_view::npos;
+    if (second.at < first.at) {
+        std::swap(first, second);
+    }
+    size_t pos = 0;
+    for (const Placeholder& placeholder : {first, second}) {
+        if (placeholder.at == std::string_view::npos) continue;
+        out_->write(prefix.substr(pos, placeholder.at - pos));
+        out_->write(placeholder.text);
+        pos = placeholder.at + placeholder.length;
+    }
+    out_->write(prefix.substr(pos));
+    if (!hasValue) {
+        out_->write(formattedValue);  // No $value placeholder, append value at end (backward compatibility)
+    }
+    out_->write("\n");
 }
 
 void RPNCalculator::print(double value, const std::string& token) const {
-    std::cout << outputPrefix_ << token << " → " << formatNumber(value) << std::endl;
+    if (printSuppressed()) {
+        resultPending_ = true;
+        return;
+    }
+    out_->write(outputPrefix_);
+    out_->write(token);
+    out_->write(" → ");
+    out_->write(formatNumber(value));
+    out_->write("\n");
+}
+
+void RPNCalculator::printResult() {
+    if (resultPending_) {
+        resultPending_ = false;
+        writeValue(stack_.peek());
+    }
 }
 
 void RPNCalculator::printStatus(const std::string& message) const {
-    std::cout << message << std::endl;
+    if (streaming_) {
+        out_->writeError(message + '\n');
+        return;
+    }
+    out_->write(message);
+    out_->write("\n");
 }
 
 void RPNCalculator::printError(const std::string& message) const {
-    std::cerr << message << std::endl;
+    std::string line = message + '\n';
+    out_->writeError(line);
+}
+
+void RPNCalculator::setOutput(OutputSink* sink) {
+    out_->flush();
+    out_ = sink;
+}
+
+void RPNCalculator::flushOutput() {
+    out_->flush();
 }
 
 // ============================================================================
@@ -647,19 +513,33 @@ void RPNCalculator::detectLocaleSeparators() {
         thousandsSeparator_ = (decimalSeparator_ == ',') ? '.' : ',';
     }
 
-    // Reset to C locale for stod to work correctly
+    // Reset to C locale; separators are handled by parseNumber/formatNumber
     std::setlocale(LC_NUMERIC, "C");
 }
 
 // ============================================================================
-// NUMBER VALIDATION
+// NUMBER LEXING
 // ============================================================================
-bool RPNCalculator::isNumber(const std::string& token) const {
-    if (token.empty()) return false;
+
+// Validates token against the locale separators and converts it in one pass:
+// separators are dropped or mapped to '.' while copying into a stack buffer,
+// which std::from_chars then parses without allocating or throwing.
+RPNCalculator::NumberParse RPNCalculator::parseNumber(std::string_view token, double& value) const {
+    if (token.empty()) return NumberParse::INVALID;
+
+    char stackBuf[64];
+    std::string heapBuf;  // Only for tokens longer than stackBuf
+    char* out = stackBuf;
+    if (token.length() > sizeof(stackBuf)) {
+        heapBuf.resize(token.length());
+        out = &heapBuf[0];
+    }
+    char* const outStart = out;
 
     size_t start = 0;
     if (token[0] == '-' || token[0] == '+') {
-        if (token.length() == 1) return false;
+        if (token.length() == 1) return NumberParse::INVALID;
+        if (token[0] == '-') *out++ = '-';  // from_chars rejects a leading '+'
         start = 1;
     }
 
@@ -673,89 +553,75 @@ bool RPNCalculator::isNumber(const std::string& token) const {
         char c = token[i];
 
         if (c == decimalSeparator_) {
-            if (hasDecimal || hasExponent) return false;
+            if (hasDecimal || hasExponent) return NumberParse::INVALID;
             hasDecimal = true;
             digitsSinceThousands = 0;  // Reset for decimal portion
+            *out++ = '.';
         } else if (c == thousandsSeparator_ && !hasDecimal && !hasExponent) {
             // Thousands separator only valid before decimal point and exponent
             // Must have 1-3 digits before first thousands separator
             // Must have exactly 3 digits between subsequent separators
-            if (hasThousandsSep && digitsSinceThousands != 3) return false;
-            if (!hasThousandsSep && (digitsSinceThousands < 1 || digitsSinceThousands > 3)) return false;
+            if (hasThousandsSep && digitsSinceThousands != 3) return NumberParse::INVALID;
+            if (!hasThousandsSep && (digitsSinceThousands < 1 || digitsSinceThousands > 3)) {
+                return NumberParse::INVALID;
+            }
             hasThousandsSep = true;
             digitsSinceThousands = 0;
         } else if (c == 'e' || c == 'E') {
-            if (hasExponent || !hasDigit) return false;
-            if (i == start) return false;
+            if (hasExponent || !hasDigit) return NumberParse::INVALID;
+            if (i == start) return NumberParse::INVALID;
             // If we had thousands separators, last group must be 3 digits (unless we hit decimal)
-            if (hasThousandsSep && !hasDecimal && digitsSinceThousands != 3) return false;
+            if (hasThousandsSep && !hasDecimal && digitsSinceThousands != 3) return NumberParse::INVALID;
             hasExponent = true;
             hasThousandsSep = false;  // Reset for exponent
+            *out++ = 'e';
             if (i + 1 < token.length() && (token[i + 1] == '+' || token[i + 1] == '-')) {
                 i++;
-                if (i + 1 >= token.length()) return false;
+                if (i + 1 >= token.length()) return NumberParse::INVALID;
+                *out++ = token[i];
             }
-        } else if (isdigit(c)) {
+        } else if (isdigit(static_cast<unsigned char>(c))) {
             digitsSinceThousands++;
             hasDigit = true;
+            *out++ = c;
         } else {
-            return false;
+            return NumberParse::INVALID;
         }
     }
 
     // Final validation: if thousands separators were used, last group must be 3 digits
     // (unless a decimal point was encountered)
     if (hasThousandsSep && !hasDecimal && !hasExponent && digitsSinceThousands != 3) {
-        return false;
+        return NumberParse::INVALID;
     }
+    if (!hasDigit) return NumberParse::INVALID;
 
-    return hasDigit;
+    // A dangling exponent ("1e") parses as the mantissa, as strtod would
+    auto result = std::from_chars(outStart, out, value);
+    if (result.ec == std::errc::result_out_of_range) return NumberParse::OUT_OF_RANGE;
+    if (result.ec != std::errc()) return NumberParse::INVALID;
+    return NumberParse::OK;
 }
 
-// ============================================================================
-// NUMBER NORMALIZATION
-// ============================================================================
-std::string RPNCalculator::normalizeNumber(const std::string& token) const {
-    std::string result;
-    result.reserve(token.length());
-
-    for (char c : token) {
-        if (c == thousandsSeparator_) {
-            // Skip thousands separators
-            continue;
-        } else if (c == decimalSeparator_) {
-            // Convert locale decimal to standard decimal
-            result += '.';
-        } else {
-            result += c;
-        }
-    }
-
-    return result;
+bool RPNCalculator::isNumber(const std::string& token) const {
+    double value;
+    return parseNumber(token, value) != NumberParse::INVALID;
 }
 
 // ============================================================================
 // OPERATOR EXTRACTION
 // ============================================================================
-std::string RPNCalculator::extractOperator(const std::string& token, size_t& opStart) const {
-    OperatorRegistry& registry = OperatorRegistry::instance();
-    const auto& ops = registry.getNamesSortedByLengthDesc();
-
-    // First search registered operators (already sorted by length desc)
-    for (const auto& op : ops) {
-        if (token.length() >= op.length()) {
-            size_t pos = token.length() - op.length();
-            if (token.compare(pos, op.length(), op) == 0) {
-                opStart = pos;
-                return op;
-            }
-        }
+std::string_view RPNCalculator::extractOperator(std::string_view token, size_t& opStart) const {
+    // First search registered operators (longest matching suffix wins)
+    std::string_view op = registry_->findLongestSuffix(token, opStart);
+    if (!op.empty()) {
+        return op;
     }
 
     // Then check special commands not in registry
     static const char* specials[] = {"sto", "rcl", nullptr};
     for (int i = 0; specials[i] != nullptr; ++i) {
-        const std::string op = specials[i];
+        const std::string_view op = specials[i];
         if (token.length() >= op.length()) {
             size_t pos = token.length() - op.length();
             if (token.compare(pos, op.length(), op) == 0) {
@@ -765,54 +631,88 @@ std::string RPNCalculator::extractOperator(const std::string& token, size_t& opS
         }
     }
 
-    return "";
+    return {};
 }
 
 // ============================================================================
 // TOKEN PROCESSING
 // ============================================================================
-void RPNCalculator::processToken(std::string token) {
-    if (token.empty()) return;
+void RPNCalculator::processToken(std::string_view source) {
+    if (source.empty()) return;
     
-    // Normalize to lowercase for case-insensitive matching
-    std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+    // Normalize to lowercase for case-insensitive matching (except array file
+    // paths).  The copy also detaches the token from its source, which the
+    // token may redefine.
+    const bool loadsArray = source.size() > 1 && source[0] == '<' && !findBuiltin(source);
+    char small[64];
+    std::string large;
+    char* lower = small;
+    if (source.size() > sizeof(small)) {
+        large.resize(source.size());
+        lower = &large[0];
+    }
+    if (loadsArray) {
+        std::copy(source.begin(), source.end(), lower);
+    } else {
+        std::transform(source.begin(), source.end(), lower, ::tolower);
+    }
+    const std::string_view token(lower, source.size());
     
     // Set current token for output annotation
     currentToken_ = token;
 
     // 1) Meta commands (assignment, operator start/stop, playback)
-    if (handleMeta(token)) {
+    if (!loadsArray && handleMeta(token)) {
         currentToken_.clear();
         return;
     }
 
-    // 2) If recording, capture token
-    if (isRecording()) {
+    // 2) If recording, capture token (tokens run inside an operator body are not recorded)
+    if (isRecording() && callDepth_ == 0 && macroDepth_ == 0) {
         if (!definingOp_.empty()) {
             // Operator definition: capture and execute for interactive feedback
-            definingBuffer_.push_back(token);
+            definingBuffer_.emplace_back(token);
         } else {
             // Temporary operator recording: capture and execute
-            recordingBuffer_.push_back(token);
+            recordingBuffer_.emplace_back(token);
         }
+        // Control structures only run compiled, so they are captured without
+        // running, from the word that opens one to the word that closes it
+        ControlWord control = controlWord(token);
+        if (opensControl(control)) {
+            recordingControl_++;
+        } else if (closesControl(control) && recordingControl_ > 0) {
+            recordingControl_--;
+        }
+        if (control != ControlWord::NONE || recordingControl_ > 0) {
+            currentToken_.clear();
+            return;
+        }
+    }
+
+    // 3) Array file ("<data.txt")
+    if (loadsArray) {
+        loadArray(token.substr(1));
+        currentToken_.clear();
+        return;
     }
 
-    // 3) Special built-ins not in OperatorRegistry (sto/rcl/scale/fmt)
+    // 4) Special built-ins not in OperatorRegistry (sto/rcl/scale/fmt)
     if (handleSpecial(token)) {
         currentToken_.clear();
         return;
     }
 
-    // 4) Inline numeric + operator (e.g., "5+", "45tan")
+    // 5) Inline numeric + operator (e.g., "5+", "45tan")
     if (handleInlineNumericOp(token)) {
         currentToken_.clear();
         return;
     }
 
-    // 5) ENTER key - HP-style stack lift and duplicate X
+    // 6) ENTER key - HP-style stack lift and duplicate X
     if (token == "enter") {
         if (!stack_.empty()) {
-            double x = stack_.top();
+            double x = stack_.peek();
             stack_.push(x);  // Duplicate X
             print(x);
         }
@@ -820,348 +720,179 @@ void RPNCalculator::processToken(std::string token) {
         return;
     }
     
-    // 6) Plain number
-    if (isNumber(token)) {
-        try {
-            double num = std::stod(normalizeNumber(token));
-            // In this token-based system, always lift for separate number tokens
-            // (HP behavior is more nuanced for interactive digit entry)
-            stack_.push(num);
-            print(num);
-            stackLiftEnabled_ = true;  // Keep lift enabled for next operation
-        } catch (const std::out_of_range&) {
-            printError("Error: Number out of range '" + token + "'");
-        }
+    // 7) Plain number
+    double num;
+    NumberParse parsed = parseNumber(token, num);
+    if (parsed == NumberParse::OK) {
+        // In this token-based system, always lift for separate number tokens
+        // (HP behavior is more nuanced for interactive digit entry)
+        stack_.push(num);
+        print(num);
+        stackLiftEnabled_ = true;  // Keep lift enabled for next operation
+        return;
+    }
+    if (parsed == NumberParse::OUT_OF_RANGE) {
+        printError("Error: Number out of range '" + std::string(token) + "'");
         return;
     }
 
-    // 6) Operator, temporary operator, or variable
-    OperatorRegistry& registry = OperatorRegistry::instance();
-    if (const Operator* op = registry.getOperator(token)) {
-        op->execute(*this);
+    // 8) Operator, temporary operator, or variable.  Built-ins are found by
+    //    perfect hash; the rest share one name lookup.
+    SymbolId id = kNoSymbol;
+    const Operator* op = findBuiltin(token);
+    if (!op) {
+        id = SymbolTable::instance().find(token);
+        op = registry_->getUserOperator(id);
+    }
+    if (op) {
+        if (liveArrays_ || profiling_) {
+            callOperator(*op);
+        } else {
+            op->execute(*this, *op);
+        }
         return;
     }
     // Check for temporary operator (no @ needed anymore)
-    if (hasNamedMacro(token)) {
-        executeMacro(token);
+    if (const auto* macro = findMacro(id)) {
+        playMacro(*macro, token);
         return;
     }
-    // Check named variables first (takes precedence over stack references in operator context)
-    if (hasVariable(token)) {
-        double value = recallVariable(token);
-        stack_.push(value);
-        print(value);
+    // Check frame registers and named variables first (take precedence over stack references)
+    const double* value = autobindXYZ_ ? findRegister(registerIndex(token)) : nullptr;
+    if (!value) {
+        value = findVariable(id);
+    }
+    if (value) {
+        stack_.push(*value);
+        print(*value);
         return;
     }
     // Check for x, y, z, t special stack references (when autobind enabled)
     if (autobindXYZ_ && (token == "x" || token == "y" || token == "z" || token == "t")) {
-        size_t size = stackSize();
-        if (token == "x" && size >= 1) {
-            double value = peekStack();
-            pushStack(value);
-            print(value);
-            return;
-        } else if (token == "y" && size >= 2) {
-            double x = popStack();
-            double y = peekStack();
-            pushStack(x);
-            pushStack(y);
-            print(y);
-            return;
-        } else if (token == "z" && size >= 3) {
-            double x = popStack();
-            double y = popStack();
-            double z = peekStack();
-            pushStack(y);
-            pushStack(x);
-            pushStack(z);
-            print(z);
-            return;
-        } else if (token == "t" && size >= 4) {
-            double x = popStack();
-            double y = popStack();
-            double z = popStack();
-            double t = peekStack();
-            pushStack(z);
-            pushStack(y);
-            pushStack(x);
-            pushStack(t);
-            print(t);
+        size_t level = (token == "x") ? 0 : (token == "y") ? 1 : (token == "z") ? 2 : 3;
+        if (level < stack_.size()) {
+            stack_.pick(level);
+            print(stack_.peek());
             return;
         } else {
-            printError("Error: Stack position '" + token + "' not available");
+            printError("Error: Stack position '" + std::string(token) + "' not available");
             return;
         }
     }
 
-    // 7) Unknown
+    // 9) Unknown
     currentToken_.clear();
-    printError("Error: Invalid input '" + token + "'");
+    if (controlWord(token) != ControlWord::NONE) {
+        // Left unresolved by the compiler, or typed outside a body
+        printError(callDepth_ > 0 || macroDepth_ > 0
+                   ? "Error: Unmatched '" + std::string(token) + "'"
+                   : "Error: '" + std::string(token) + "' only works inside an operator body");
+        return;
+    }
+    printError("Error: Invalid input '" + std::string(token) + "'");
 }
 
-void RPNCalculator::processStatement(const std::string& statement) {
+// Next whitespace-delimited token of text at or after pos (empty at the end)
+static std::string_view nextToken(std::string_view text, size_t& pos) {
+    static const char* const kSpace = " \t\n\v\f\r";
+    size_t start = text.find_first_not_of(kSpace, pos);
+    if (start == std::string_view::npos) {
+        pos = text.size();
+        return {};
+    }
+    pos = std::min(text.find_first_of(kSpace, start), text.size());
+    return text.substr(start, pos - start);
+}
+
+void RPNCalculator::processStatement(std::string_view stmt) {
+    if (handleProfileCommand(stmt)) return;
+
     // Step 1: Extract trailing quoted description after the last '}'.
     // e.g. double{d +} "double the value" -> desc extracted, stmt trimmed to double{d +}
-    std::string stmt = statement;
     size_t lastClose = stmt.rfind('}');
-    if (lastClose != std::string::npos) {
+    if (lastClose != std::string_view::npos) {
         size_t q = stmt.find_first_not_of(" \t", lastClose + 1);
-        if (q != std::string::npos && stmt[q] == '"') {
+        if (q != std::string_view::npos && stmt[q] == '"') {
             size_t qEnd = stmt.rfind('"');
             if (qEnd > q) {
-                pendingOpDescription_ = stmt.substr(q + 1, qEnd - q - 1);
+                pendingOpDescription_.assign(stmt.substr(q + 1, qEnd - q - 1));
                 stmt = stmt.substr(0, lastClose + 1);
             }
         }
     }
 
-    // Step 2: Build token list.  When a '{' is present we scan at the statement
+    // Step 2: Run the tokens.  When a '{' is present we scan at the statement
     // level so that bodies with spaces (e.g. "name{d +}") are handled correctly.
-    std::vector<std::string> tokens;
+    size_t pos = 0;
+    std::string_view tok;
     size_t openBrace = stmt.find('{');
+    if (openBrace == std::string_view::npos) {
+        // No braces: plain whitespace tokenization
+        while (!(tok = nextToken(stmt, pos)).empty()) processToken(tok);
+        return;
+    }
 
-    if (openBrace != std::string::npos) {
-        // Tokenize the part before '{'
-        std::string nameToken;
-        std::istringstream preSS(stmt.substr(0, openBrace));
-        std::string tok;
-        while (preSS >> tok) {
-            if (!nameToken.empty()) tokens.push_back(nameToken);
-            nameToken = tok;
-        }
-        // nameToken is the operator name; emit "name{"
-        tokens.push_back(nameToken + "{");
-
-        size_t closeBrace = stmt.find('}', openBrace);
-        if (closeBrace != std::string::npos) {
-            // Tokenize the body
-            std::string body = stmt.substr(openBrace + 1, closeBrace - openBrace - 1);
-            std::istringstream bodySS(body);
-            while (bodySS >> tok) tokens.push_back(tok);
-            tokens.push_back("}");
-
-            // Any tokens after '}' (unusual, but handle gracefully)
-            std::istringstream postSS(stmt.substr(closeBrace + 1));
-            while (postSS >> tok) tokens.push_back(tok);
-        } else {
-            // No closing brace — '{' starts an interactive definition
-            std::istringstream restSS(stmt.substr(openBrace + 1));
-            while (restSS >> tok) tokens.push_back(tok);
-        }
+    // Tokens before '{'; the last one is the operator name
+    std::string_view head = stmt.substr(0, openBrace);
+    std::string_view nameToken;
+    while (!(tok = nextToken(head, pos)).empty()) {
+        if (!nameToken.empty()) processToken(nameToken);
+        nameToken = tok;
+    }
+    // Emit "name{", which is contiguous in the line unless written "name {"
+    if (nameToken.empty() || nameToken.data() + nameToken.size() == stmt.data() + openBrace) {
+        processToken(std::string_view(stmt.data() + openBrace - nameToken.size(), nameToken.size() + 1));
     } else {
-        // No braces — plain whitespace tokenization
-        std::istringstream iss(stmt);
-        std::string tok;
-        while (iss >> tok) tokens.push_back(tok);
+        processToken(std::string(nameToken) + "{");
     }
 
-    for (const auto& t : tokens) {
-        processToken(t);
+    size_t closeBrace = stmt.find('}', openBrace);
+    if (closeBrace == std::string_view::npos) {
+        // No closing brace: '{' starts an interactive definition
+        pos = openBrace + 1;
+        while (!(tok = nextToken(stmt, pos)).empty()) processToken(tok);
+        return;
+    }
+    std::string_view body = stmt.substr(0, closeBrace);
+    pos = openBrace + 1;
+    while (!(tok = nextToken(body, pos)).empty()) processToken(tok);
+    processToken(stmt.substr(closeBrace, 1));
+
+    // Any tokens after '}' (unusual, but handle gracefully)
+    pos = closeBrace + 1;
+    while (!(tok = nextToken(stmt, pos)).empty()) processToken(tok);
+}
+
+void RPNCalculator::processStatements(std::string_view line) {
+    refreshRegistry();
+
+    // Split by semicolons to handle multi-statement lines
+    while (!line.empty()) {
+        size_t semi = std::min(line.find(';'), line.size());
+        if (semi > 0) {
+            processStatement(line.substr(0, semi));
+        }
+        line.remove_prefix(std::min(semi + 1, line.size()));
     }
 }
 
 void RPNCalculator::processLine(const std::string& line) {
     // Handle empty line (Enter pressed) - just show current X (HP-style)
     if (line.empty() || line.find_first_not_of(" \t") == std::string::npos) {
-        if (stack_.empty()) {
-            print(0);
-        } else {
-            print(stack_.top());
-        }
+        // An explicit request to see X, shown even in quiet mode
+        writeValue(stack_.peek());
+        resultPending_ = false;
         removeTrailingZeros();
         return;
     }
     
-    // Split by semicolons to handle multi-statement lines
-    std::string current;
-    for (char c : line) {
-        if (c == ';') {
-            if (!current.empty()) {
-                processStatement(current);
-                current.clear();
-            }
-        } else {
-            current += c;
-        }
-    }
-    if (!current.empty()) {
-        processStatement(current);
+    processStatements(line);
+    if (quiet_) {
+        currentToken_.clear();
+        printResult();
     }
     removeTrailingZeros();
-}
-
-// ============================================================================
-// CONFIGURATION
-// ============================================================================
-void RPNCalculator::loadConfig() {
-    // Try local .rpn first, then fall back to ~/.rpn
-    std::string configPath = ".rpn";
-    std::ifstream configFile(configPath);
-    
-    if (!configFile.is_open()) {
-        const char* home = getenv("HOME");
-        if (!home) return;
-        configPath = std::string(home) + "/.rpn";
-        configFile.open(configPath);
-        if (!configFile.is_open()) return;
-    }
-    
-    std::string line;
-    while (std::getline(configFile, line)) {
-        if (line.empty() || line[0] == '#') continue;
-        
-        std::istringstream iss(line);
-        std::string cmd;
-        iss >> cmd;
-        
-        if (cmd == "deg") {
-            angleMode_ = AngleMode::DEGREES;
-        } else if (cmd == "rad") {
-            angleMode_ = AngleMode::RADIANS;
-        } else if (cmd == "grd") {
-            angleMode_ = AngleMode::GRADIANS;
-        } else if (cmd == "scale" || cmd == "fix") {
-            int s;
-            if (iss >> s && s >= 0 && s <= 15) {
-                scale_ = s;
-            }
-        } else if (cmd == "mem") {
-            int loc;
-            double val;
-            if (iss >> loc >> val) {
-                memory_[loc] = val;
-            }
-        } else if (cmd == "fmt") {
-            std::string value;
-            if (iss >> value) {
-                if (value == "off" || value == "0" || value == "false") {
-                    localeFormatting_ = false;
-                } else if (value == "on" || value == "1" || value == "true") {
-                    localeFormatting_ = true;
-                }
-            }
-        } else if (cmd == "autobind") {
-            std::string value;
-            if (iss >> value) {
-                if (value == "off" || value == "0" || value == "false") {
-                    autobindXYZ_ = false;
-                } else if (value == "on" || value == "1" || value == "true") {
-                    autobindXYZ_ = true;
-                }
-            }
-        } else if (cmd == "var") {
-            // var <name> <value>
-            std::string name;
-            double val;
-            if (iss >> name >> val) {
-                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-                // Silently ignore if it would shadow an operator
-                storeVariable(name, val);
-            }
-        } else if (cmd == "operator") {
-            // operator <name> <description words...> : <tokens...>
-            std::string name;
-            if (iss >> name) {
-                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-                // Read the rest of the line to split on ':'
-                std::string rest;
-                std::getline(iss, rest);
-                size_t colonPos = rest.find(':');
-                std::string description = "User-defined";
-                std::vector<std::string> tokens;
-                if (colonPos != std::string::npos) {
-                    // Description is before ':', tokens after
-                    std::string descPart = rest.substr(0, colonPos);
-                    // Trim whitespace from description
-                    size_t start = descPart.find_first_not_of(" \t");
-                    size_t end = descPart.find_last_not_of(" \t");
-                    if (start != std::string::npos) {
-                        description = descPart.substr(start, end - start + 1);
-                    }
-                    std::string tokenPart = rest.substr(colonPos + 1);
-                    std::istringstream tiss(tokenPart);
-                    std::string tok;
-                    while (tiss >> tok) {
-                        tokens.push_back(tok);
-                    }
-                } else {
-                    // No colon — everything is tokens, use default description
-                    std::istringstream tiss(rest);
-                    std::string tok;
-                    while (tiss >> tok) {
-                        tokens.push_back(tok);
-                    }
-                }
-                if (!tokens.empty()) {
-                    registerUserOperator(name, description, tokens);
-                }
-            }
-        } else if (cmd == "prefix") {
-            // prefix "<string>" - Set output prefix (quoted string)
-            // Read the rest of the line and extract quoted string
-            std::string rest;
-            std::getline(iss, rest);
-            // Trim leading whitespace
-            size_t start = rest.find_first_not_of(" \t");
-            if (start != std::string::npos) {
-                rest = rest.substr(start);
-                // Check for quotes
-                if (!rest.empty() && rest[0] == '"') {
-                    // Find closing quote
-                    size_t endQuote = rest.find('"', 1);
-                    if (endQuote != std::string::npos) {
-                        // Extract string between quotes, handling escape sequences
-                        std::string quoted = rest.substr(1, endQuote - 1);
-                        /* Process escape sequences: \t \n \\ \" */
-                        std::string processed;
-                        for (size_t i = 0; i < quoted.length(); ++i) {
-                            if (quoted[i] == '\\' && i + 1 < quoted.length()) {
-                                char next = quoted[i + 1];
-                                if (next == 't') {
-                                    processed += '\t';
-                                    ++i;
-                                } else if (next == 'n') {
-                                    processed += '\n';
-                                    ++i;
-                                } else if (next == '\\') {
-                                    processed += '\\';
-                                    ++i;
-                                } else if (next == '"') {
-                                    processed += '"';
-                                    ++i;
-                                } else {
-                                    processed += quoted[i];
-                                }
-                            } else {
-                                processed += quoted[i];
-                            }
-                        }
-                        outputPrefix_ = processed;
-                    }
-                } else {
-                    // No quotes - use rest of line as-is for backward compatibility
-                    outputPrefix_ = rest;
-                }
-            } else {
-                outputPrefix_ = "";  // Empty prefix
-            }
-        } else if (cmd == "macro") {
-            // macro <name> <tokens...> (deprecated keyword, use name[ ] syntax instead)
-            std::string name;
-            if (iss >> name) {
-                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-                std::vector<std::string> tokens;
-                std::string token;
-                while (iss >> token) {
-                    tokens.push_back(token);
-                }
-                if (!tokens.empty()) {
-                    namedMacros_[name] = tokens;
-                }
-            }
-        }
-    }
-    configFile.close();
+    if (liveArrays_) sweepArrays();
 }
 
 // ============================================================================
@@ -1171,7 +902,7 @@ void RPNCalculator::loadConfig() {
 // Initialize the completion list with all operators and commands (encapsulated in OperatorRegistry)
 static void initCompletions() {
     OperatorRegistry& registry = OperatorRegistry::instance();
-    registry.setBuiltinCompletions({"sto", "rcl", "scale", "fmt", "quit", "exit"});
+    registry.setBuiltinCompletions({"sto", "rcl", "scale", "fmt", "quiet", "quietops", "prof", "quit", "exit"});
 }
 
 // Readline completion generator - returns matches one at a time
@@ -1221,7 +952,7 @@ void RPNCalculator::run() {
     // Disable default filename completion
     rl_bind_key('\t', rl_complete);
     
-    std::cout << "RPN Calculator (type 'help' or '?' for commands, 'q' to quit)" << std::endl;
+    printStatus("RPN Calculator (type 'help' or '?' for commands, 'q' to quit)");
     
     while (true) {
         // Build prompt with recording indicator
@@ -1236,11 +967,13 @@ void RPNCalculator::run() {
             prompt = std::to_string(stack_.size()) + "> ";
         }
         
+        // Everything from the previous line must be visible before the prompt
+        flushOutput();
         char* input = readline(prompt.c_str());
         
         // EOF (Ctrl-D)
         if (!input) {
-            std::cout << std::endl;
+            printStatus("");
             break;
         }
         
@@ -1256,25 +989,30 @@ void RPNCalculator::run() {
         if (line == "q" || line == "quit" || line == "exit") {
             // Discard any in-progress recording
             if (isRecording()) {
-                std::cout << "Recording discarded" << std::endl;
+                printStatus("Recording discarded");
                 recordingName_.clear();
                 recordingBuffer_.clear();
                 definingOp_.clear();
                 definingBuffer_.clear();
                 
                 // Clear x,y,z,t snapshots if they were set during recording
-                if (autobindXYZ_) {
-                    namedVariables_.erase("x");
-                    namedVariables_.erase("y");
-                    namedVariables_.erase("z");
-                    namedVariables_.erase("t");
-                }
+                endRecordingFrame();
             }
             break;
         }
         
+        // While the line runs, Ctrl-C stops a runaway operator rather than
+        // the calculator
+        interrupted_ = 0;
+        struct sigaction action, saved;
+        std::memset(&action, 0, sizeof action);
+        action.sa_handler = [](int) { interrupted_ = 1; };
+        sigemptyset(&action.sa_mask);
+        ::sigaction(SIGINT, &action, &saved);
         processLine(line);
+        ::sigaction(SIGINT, &saved, nullptr);
     }
+    flushOutput();
 }
 
 // ============================================================================
@@ -1285,28 +1023,94 @@ void RPNCalculator::evaluate(const std::string& expr) {
     processLine(expr);
     // Print final result (top of stack) if not already printed
     // The result is typically already printed by the operators
+    flushOutput();  // Batch mode: output is only flushed once, at the end
+}
+
+void RPNCalculator::streamLine(std::string_view line, bool carryStack) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    if (!carryStack) {
+        stack_.clear();
+        lastX_ = 0.0;
+        stackLiftEnabled_ = true;
+    }
+    processStatements(line);
+    resultPending_ = false;
+
+    // Blank result when the stack is empty keeps input and output lines paired
+    if (!stack_.empty()) {
+        out_->write(formatNumber(stack_.peek()));
+    }
+    out_->write("\n");
+    removeTrailingZeros();
+    if (liveArrays_) sweepArrays();
+}
+
+void RPNCalculator::stream(std::FILE* in, bool carryStack) {
+    loadConfig();
+    streaming_ = true;
+    quiet_ = true;  // Nothing is formatted until the line's result
+    streamInput(in, carryStack, {});
+}
+
+void RPNCalculator::streamInput(std::FILE* in, bool carryStack, std::string_view head) {
+    // Lines are evaluated in place in the read buffer; a partial line at the
+    // end of a block is moved to the front before the next read
+    std::vector<char> buffer(std::max<size_t>(1 << 20, head.size()));
+    std::copy(head.begin(), head.end(), buffer.begin());
+    size_t filled = head.size();
+    bool eof = false;
+    while (!eof || filled > 0) {
+        if (!eof) {
+            if (filled == buffer.size()) {
+                buffer.resize(buffer.size() * 2);  // Line longer than the buffer
+            }
+            size_t n = std::fread(buffer.data() + filled, 1, buffer.size() - filled, in);
+            filled += n;
+            eof = n == 0;
+        }
+
+        const char* data = buffer.data();
+        size_t start = 0;
+        while (start < filled) {
+            const char* nl = static_cast<const char*>(std::memchr(data + start, '\n', filled - start));
+            if (!nl && !eof) break;  // Wait for the rest of the line
+            size_t end = nl ? static_cast<size_t>(nl - data) : filled;
+            std::string_view line(data + start, end - start);
+            start = nl ? end + 1 : filled;
+            streamLine(line, carryStack);
+        }
+        std::memmove(buffer.data(), data + start, filled - start);
+        filled -= start;
+        flushOutput();  // Results of the block survive if the run is killed later
+    }
 }
 
 // ============================================================================
 // PROCESS TOKEN HELPERS
 // ============================================================================
 
-bool RPNCalculator::handleMeta(const std::string& token) {
-    OperatorRegistry& registry = OperatorRegistry::instance();
+bool RPNCalculator::handleMeta(std::string_view token) {
 
-    // Variable assignment: name=
-    if (token.size() > 1 && token.back() == '=') {
-        std::string varName = token.substr(0, token.size() - 1);
+    // Variable assignment: name= (but not a comparison such as "<=")
+    if (token.size() > 1 && token.back() == '=' && !findBuiltin(token)) {
+        std::string varName(token.substr(0, token.size() - 1));
         if (stack_.empty()) {
             printError("Error: Need value on stack for assignment");
             return true;
         }
-        double value = stack_.top();
+        double value = stack_.peek();
         if (!storeVariable(varName, value)) {
             printError("Error: Cannot use '" + varName + "' as variable name (shadows operator)");
             return true;
         }
-        std::cout << outputPrefix_ << varName << " = " << formatNumber(value) << std::endl;
+        if (streaming_) return true;  // stdout carries only the line results
+        out_->write(outputPrefix_);
+        out_->write(varName);
+        out_->write(" = ");
+        out_->write(formatNumber(value));
+        out_->write("\n");
         return true;
     }
 
@@ -1317,44 +1121,22 @@ bool RPNCalculator::handleMeta(const std::string& token) {
             printError("Error: Already recording '" + current + "'");
             return true;
         }
-        std::string macroName = token.substr(0, token.size() - 1);
-        if (registry.hasOperator(macroName)) {
+        std::string macroName(token.substr(0, token.size() - 1));
+        if (registry_->hasOperator(macroName) || controlWord(macroName) != ControlWord::NONE) {
             printError("Error: Cannot use '" + macroName + "' as temporary operator name (shadows operator)");
             return true;
         }
         recordingName_ = macroName;
         recordingBuffer_.clear();
+        recordingControl_ = 0;
         
         // Bind x,y,z,t to current stack positions as read-only snapshots during recording
         if (autobindXYZ_) {
-            size_t size = stackSize();
-            if (size >= 1) {
-                namedVariables_["x"] = peekStack();
-            }
-            if (size >= 2) {
-                double topVal = popStack();
-                namedVariables_["y"] = peekStack();
-                pushStack(topVal);
-            }
-            if (size >= 3) {
-                double xVal = popStack();
-                double yVal = popStack();
-                namedVariables_["z"] = peekStack();
-                pushStack(yVal);
-                pushStack(xVal);
-            }
-            if (size >= 4) {
-                double xVal = popStack();
-                double yVal = popStack();
-                double zVal = popStack();
-                namedVariables_["t"] = peekStack();
-                pushStack(zVal);
-                pushStack(yVal);
-                pushStack(xVal);
-            }
+            pushFrame();
+            recordingFrame_ = frames_.size();
         }
         
-        std::cout << "Defining temporary operator '" << recordingName_ << "'..." << std::endl;
+        printStatus("Defining temporary operator '" + recordingName_ + "'...");
         return true;
     }
 
@@ -1365,9 +1147,16 @@ bool RPNCalculator::handleMeta(const std::string& token) {
             printError("Error: Already recording '" + current + "'");
             return true;
         }
-        std::string opName = token.substr(0, token.size() - 1);
-        if (registry.hasOperator(opName)) {
-            const Operator* existing = registry.getOperator(opName);
+        if (sharedRegistry_) {
+            printError("Error: Operators cannot be defined in parallel or daemon mode");
+            return true;
+        }
+        std::string opName(token.substr(0, token.size() - 1));
+        if (controlWord(opName) != ControlWord::NONE) {
+            printError("Error: Cannot use '" + opName + "' as operator name (control word)");
+            return true;
+        }
+        if (const Operator* existing = registry_->getOperator(opName)) {
             if (existing->category != OperatorCategory::USER) {
                 printError("Error: Cannot use '" + opName + "' as operator name (shadows built-in)");
                 return true;
@@ -1375,37 +1164,15 @@ bool RPNCalculator::handleMeta(const std::string& token) {
         }
         definingOp_ = opName;
         definingBuffer_.clear();
+        recordingControl_ = 0;
         
         // Bind x,y,z,t to current stack positions as read-only snapshots during recording
         if (autobindXYZ_) {
-            size_t size = stackSize();
-            if (size >= 1) {
-                namedVariables_["x"] = peekStack();
-            }
-            if (size >= 2) {
-                double topVal = popStack();
-                namedVariables_["y"] = peekStack();
-                pushStack(topVal);
-            }
-            if (size >= 3) {
-                double xVal = popStack();
-                double yVal = popStack();
-                namedVariables_["z"] = peekStack();
-                pushStack(yVal);
-                pushStack(xVal);
-            }
-            if (size >= 4) {
-                double xVal = popStack();
-                double yVal = popStack();
-                double zVal = popStack();
-                namedVariables_["t"] = peekStack();
-                pushStack(zVal);
-                pushStack(yVal);
-                pushStack(xVal);
-            }
+            pushFrame();
+            recordingFrame_ = frames_.size();
         }
         
-        std::cout << "Defining operator '" << definingOp_ << "'..." << std::endl;
+        printStatus("Defining operator '" + definingOp_ + "'...");
         return true;
     }
 
@@ -1421,17 +1188,14 @@ bool RPNCalculator::handleMeta(const std::string& token) {
             pendingOpDescription_.clear();
             
             // Clear the x,y,z,t snapshots used during recording
-            if (autobindXYZ_) {
-                namedVariables_.erase("x");
-                namedVariables_.erase("y");
-                namedVariables_.erase("z");
-                namedVariables_.erase("t");
-            }
+            endRecordingFrame();
             
-            if (registry.hasOperator(name) && registry.getOperator(name)->category == OperatorCategory::USER) {
-                registry.removeOperator(name);
+            const Operator* existing = registry_->getOperator(name);
+            if (existing && existing->category == OperatorCategory::USER) {
+                OperatorRegistry::instance().removeOperator(name);
+                repinRegistry();
                 deleteUserOperator(name);
-                std::cout << "Deleted operator '" << name << "'" << std::endl;
+                printStatus("Deleted operator '" + name + "'");
             } else {
                 printError("Error: Operator body is empty");
             }
@@ -1445,16 +1209,15 @@ bool RPNCalculator::handleMeta(const std::string& token) {
         pendingOpDescription_.clear();
         
         // Clear the x,y,z,t snapshots used during recording
-        if (autobindXYZ_) {
-            namedVariables_.erase("x");
-            namedVariables_.erase("y");
-            namedVariables_.erase("z");
-            namedVariables_.erase("t");
-        }
+        endRecordingFrame();
         
-        if (registerUserOperator(name, desc, toks)) {
+        std::string structure = controlFlowError(toks);
+        if (!structure.empty()) {
+            printError("Error: Operator '" + name + "' not defined: " + structure);
+        } else if (registerUserOperator(name, desc, toks)) {
             saveUserOperator(name, desc, toks);
-            std::cout << "Defined operator '" << name << "' (" << toks.size() << " commands, saved to ~/.rpn)" << std::endl;
+            printStatus("Defined operator '" + name + "' (" + std::to_string(toks.size()) +
+                        " commands, saved to ~/.rpn)");
         } else {
             printError("Error: Cannot define operator '" + name + "' (shadows built-in)");
         }
@@ -1463,7 +1226,7 @@ bool RPNCalculator::handleMeta(const std::string& token) {
 
     // Temporary operator execution: name@ (backward compatibility - @ no longer required)
     if (token.size() > 1 && token.back() == '@') {
-        std::string macroName = token.substr(0, token.size() - 1);
+        std::string macroName(token.substr(0, token.size() - 1));
         executeMacro(macroName);
         return true;
     }
@@ -1476,17 +1239,19 @@ bool RPNCalculator::handleMeta(const std::string& token) {
             return true;
         }
         if (!recordingName_.empty()) {
-            namedMacros_[recordingName_] = recordingBuffer_;
-            std::cout << "Defined temporary operator '" << recordingName_ << "' (" << recordingBuffer_.size() << " commands)" << std::endl;
+            std::string structure = controlFlowError(recordingBuffer_);
+            if (!structure.empty()) {
+                printError("Error: Temporary operator '" + recordingName_ + "' not defined: " +
+                           structure);
+            } else {
+                defineMacro(recordingName_, recordingBuffer_);
+                printStatus("Defined temporary operator '" + recordingName_ + "' (" +
+                            std::to_string(recordingBuffer_.size()) + " commands)");
+            }
             recordingName_.clear();
             
             // Clear the x,y,z,t snapshots used during recording
-            if (autobindXYZ_) {
-                namedVariables_.erase("x");
-                namedVariables_.erase("y");
-                namedVariables_.erase("z");
-                namedVariables_.erase("t");
-            }
+            endRecordingFrame();
         } else {
             printError("Error: Not recording a named temporary operator");
             return true;
@@ -1499,24 +1264,29 @@ bool RPNCalculator::handleMeta(const std::string& token) {
     return false; // not handled
 }
 
-bool RPNCalculator::handleSpecial(const std::string& token) {
+bool RPNCalculator::handleSpecial(std::string_view token) {
+    // prof inside a line shows the table; its arguments need a statement of their own
+    if (token == "prof") {
+        printProfile();
+        return true;
+    }
+
     // sto (numeric slots deprecated)
     if (token == "sto") {
         if (stack_.size() < 2) {
             printError("Error: Need location and value on stack");
             return true;
         }
-        double locDouble = stack_.top();
-        stack_.pop();
+        double locDouble = stack_.pop();
         if (locDouble != std::floor(locDouble)) {
             stack_.push(locDouble);
             printError("Error: Memory location must be an integer");
             return true;
         }
         int location = static_cast<int>(locDouble);
-        double value = stack_.top();
+        double value = stack_.peek();
         memory_[location] = value;
-        std::cout << "(deprecated: use 'name=' instead)" << std::endl;
+        printStatus("(deprecated: use 'name=' instead)");
         return true;
     }
 
@@ -1526,7 +1296,7 @@ bool RPNCalculator::handleSpecial(const std::string& token) {
             printError("Error: Need location on stack");
             return true;
         }
-        double locDouble = stack_.top();
+        double locDouble = stack_.peek();
         if (locDouble != std::floor(locDouble)) {
             printError("Error: Memory location must be an integer");
             return true;
@@ -1536,7 +1306,7 @@ bool RPNCalculator::handleSpecial(const std::string& token) {
         double value = recallMemory(location);
         stack_.push(value);
         print(value);
-        std::cout << "(deprecated: use variable names instead)" << std::endl;
+        printStatus("(deprecated: use variable names instead)");
         return true;
     }
 
@@ -1546,7 +1316,7 @@ bool RPNCalculator::handleSpecial(const std::string& token) {
             printError("Error: FIX requires a value (0-15) on the stack");
             return true;
         }
-        double scaleVal = stack_.top();
+        double scaleVal = stack_.peek();
         if (scaleVal != std::floor(scaleVal)) {
             printError("Error: FIX must be an integer");
             return true;
@@ -1558,70 +1328,89 @@ bool RPNCalculator::handleSpecial(const std::string& token) {
         }
         stack_.pop();
         scale_ = newScale;
-        std::cout << "FIX " << scale_ << std::endl;
+        printStatus("FIX " + std::to_string(scale_));
         return true;
     }
     
     // show/config - display current settings
     if (token == "show" || token == "config") {
-        std::cout << "Configuration:" << std::endl;
-        std::cout << "  FIX: " << scale_ << " (decimal places)" << std::endl;
-        std::cout << "  Angle mode: ";
+        printStatus("Configuration:");
+        printStatus("  FIX: " + std::to_string(scale_) + " (decimal places)");
         if (angleMode_ == AngleMode::DEGREES) {
-            std::cout << "degrees";
+            printStatus("  Angle mode: degrees");
         } else if (angleMode_ == AngleMode::RADIANS) {
-            std::cout << "radians";
+            printStatus("  Angle mode: radians");
         } else {
-            std::cout << "gradians";
+            printStatus("  Angle mode: gradians");
         }
-        std::cout << std::endl;
-        std::cout << "  Locale formatting: " << (localeFormatting_ ? "on" : "off") << std::endl;
-        std::cout << "  Auto-bind x,y,z,t: " << (autobindXYZ_ ? "on" : "off") << std::endl;
+        printStatus(std::string("  Locale formatting: ") + (localeFormatting_ ? "on" : "off"));
+        printStatus(std::string("  Auto-bind x,y,z,t: ") + (autobindXYZ_ ? "on" : "off"));
+        printStatus(std::string("  Quiet: ") + (quiet_ ? "on" : "off"));
+        printStatus(std::string("  Quiet operators: ") + (quietOperators_ ? "on" : "off"));
+        printStatus("  Call stack: " + std::to_string(callStackBudget_ >> 20) + " MB");
         return true;
     }
 
     // fmt
     if (token == "fmt") {
         localeFormatting_ = !localeFormatting_;
-        std::cout << "Locale formatting " << (localeFormatting_ ? "on" : "off") << std::endl;
+        printStatus(std::string("Locale formatting ") + (localeFormatting_ ? "on" : "off"));
         return true;
     }
 
     // autobind
     if (token == "autobind") {
         autobindXYZ_ = !autobindXYZ_;
-        std::cout << "Auto-binding x,y,z,t " << (autobindXYZ_ ? "on" : "off") << std::endl;
+        printStatus(std::string("Auto-binding x,y,z,t ") + (autobindXYZ_ ? "on" : "off"));
+        return true;
+    }
+
+    // quiet - only show the final stack top of each line
+    if (token == "quiet") {
+        quiet_ = !quiet_;
+        resultPending_ = false;
+        printStatus(std::string("Quiet mode ") + (quiet_ ? "on" : "off"));
+        return true;
+    }
+
+    // quietops - only show the result of each top-level operator call
+    if (token == "quietops") {
+        quietOperators_ = !quietOperators_;
+        resultPending_ = false;
+        printStatus(std::string("Quiet operators ") + (quietOperators_ ? "on" : "off"));
         return true;
     }
 
     return false;
 }
 
-bool RPNCalculator::handleInlineNumericOp(const std::string& token) {
+bool RPNCalculator::handleInlineNumericOp(std::string_view token) {
     if (token.size() <= 1) return false;
 
     size_t opStart;
-    std::string op = extractOperator(token, opStart);
+    std::string_view op = extractOperator(token, opStart);
     if (!op.empty() && opStart > 0) {
-        std::string numPart = token.substr(0, opStart);
-        if (isNumber(numPart)) {
-            double num;
-            try {
-                num = std::stod(normalizeNumber(numPart));
-            } catch (const std::out_of_range&) {
-                printError("Error: Number out of range '" + numPart + "'");
-                return true;
-            }
+        std::string_view numPart = token.substr(0, opStart);
+        double num;
+        NumberParse parsed = parseNumber(numPart, num);
+        if (parsed == NumberParse::OUT_OF_RANGE) {
+            printError("Error: Number out of range '" + std::string(numPart) + "'");
+            return true;
+        }
+        if (parsed == NumberParse::OK) {
             stack_.push(num);
             currentToken_ = numPart;  // Show as plain number (no $op annotation)
             print(num);
 
             currentToken_ = op;  // Show just the operator name for $op
 
-            OperatorRegistry& registry = OperatorRegistry::instance();
-            const Operator* opObj = registry.getOperator(op);
+            const Operator* opObj = registry_->getOperator(op);
             if (opObj) {
-                opObj->execute(*this);
+                if (liveArrays_ || profiling_) {
+                    callOperator(*opObj);
+                } else {
+                    opObj->execute(*this, *opObj);
+                }
             } else if (op == "sto" || op == "rcl") {
                 // Call directly to avoid double-recording during macro capture
                 handleSpecial(op);
@@ -16,10 +16,20 @@
 #ifndef RPN_H
 #define RPN_H
 
-#include <stack>
+#include <csignal>
+#include <cstdio>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include "bytecode.h"
+#include "output.h"
+#include "rpnstack.h"
+#include "symbols.h"
+
+class RegistrySnapshot;
+struct Operator;
 
 class RPNCalculator {
 public:
@@ -28,16 +38,28 @@ public:
     // Main entry points
     void run();                              // Interactive mode
     void evaluate(const std::string& expr);  // Non-interactive: evaluate expression and print result
+    void stream(std::FILE* in, bool carryStack);  // One expression per input line, one result per output line
+    void streamParallel(std::FILE* in, unsigned jobs);  // stream() across worker threads (batch.cpp)
+    void evaluateCsv(const char* path, const std::string& expr);  // Append expr as a column (csv.cpp)
+    void serve(const std::string& socketPath);  // --daemon: serve clients until signalled (daemon.cpp)
     
     // Stack operations - these need to be public for operators to access
     void pushStack(double value);
     double popStack();  // Returns 0 if empty
-    double peekStack() const;  // Returns 0 if empty
+    double peekStack(size_t level = 0) const;  // Returns 0 past the bottom (level 0 = top)
+    void pickStack(size_t level);      // Copy level to top
+    void rollStack(size_t level);      // Move level to top
+    void rollStackDown(size_t level);  // Move top to level
     bool isStackEmpty() const;
     size_t stackSize() const;
     void clearStack();
     void printStack() const;
     
+    // Arrays (array.cpp).  Stack entries and variables stay doubles; an
+    // array is a NaN-boxed handle (array.h) to immutable elements owned here.
+    double makeArray(std::vector<double> values);             // Returns the handle
+    const std::vector<double>* getArray(double value) const;  // nullptr for scalars
+    
     // Memory operations (numeric slots - deprecated, use named variables)
     void storeMemory(int location, double value);
     double recallMemory(int location) const;
@@ -65,6 +87,10 @@ public:
     int getScale() const;
     void setAutobind(bool enabled);
     bool getAutobind() const;
+    void setQuiet(bool enabled);  // Command-line -q; takes precedence over the config file
+    void setProfiling(bool enabled);  // Command-line --prof (profile.cpp)
+    void finishProfile();             // At exit: profile as JSON on stderr, if profiling
+    void mergeProfile(const RPNCalculator& other);
     
     // Angle conversions
     double toRadians(double angle) const;
@@ -75,42 +101,177 @@ public:
     void print(double value, const std::string& token) const;  // Print with operation name
     void printStatus(const std::string& message) const;
     void printError(const std::string& message) const;
+    void setOutput(OutputSink* sink);  // Flushes the current sink first
+    void flushOutput();  // Flush point: each line interactively, each block of input in batch modes
     
     // HP-style features (public for operator access)
     double lastX_;           // LASTX register - saves last X before operations
     bool stackLiftEnabled_;  // Stack lift flag - controls if next number lifts stack
     
 private:
+    friend class Benchmarks;  // bench.cpp drives the internals directly
+
     enum class AngleMode { RADIANS, DEGREES, GRADIANS };
     
-    std::stack<double> stack_;
+    RPNStack stack_;
     std::unordered_map<int, double> memory_;
     AngleMode angleMode_;
     int scale_;
     int callDepth_;
     
     // Temporary operator recording (can be loaded from .rpn config file)
-    std::unordered_map<std::string, std::vector<std::string>> namedMacros_;  // name -> recorded tokens
+    // Bodies are immutable and shared, so copies of a calculator share them;
+    // redefining a name replaces its body
+    using MacroBody = std::shared_ptr<Program>;
+    std::vector<MacroBody> namedMacros_;  // Indexed by SymbolId
+    size_t namedMacroCount_;
+    const MacroBody* findMacro(SymbolId id) const {
+        return id < namedMacros_.size() && namedMacros_[id] ? &namedMacros_[id] : nullptr;
+    }
+    void defineMacro(const std::string& name, const std::vector<std::string>& tokens);
+    void playMacro(MacroBody macro, std::string_view name);
     std::string recordingName_;   // empty if not recording (named)
     std::vector<std::string> recordingBuffer_;
     bool isRecording() const { return !recordingName_.empty() || !definingOp_.empty(); }
-    bool isPlayingMacro_;         // Prevent nested temporary operator playback
+    int recordingControl_;        // Control structures open in the recording (captured, not run)
+    int macroDepth_;              // Temporary operators running
 
     // User-defined operator recording
     std::string definingOp_;              // empty if not defining
     std::vector<std::string> definingBuffer_;
     std::string pendingOpDescription_;    // description from trailing "..." on } line
     
-    // Named variables
-    std::unordered_map<std::string, double> namedVariables_;
+    // Named variables, indexed by SymbolId
+    std::vector<double> variableValues_;
+    std::vector<bool> variableBound_;
+    const double* findVariable(SymbolId id) const {
+        return id < variableBound_.size() && variableBound_[id] ? &variableValues_[id] : nullptr;
+    }
+    void bindVariable(SymbolId id, double value);
+
+    // Activation frames for auto-bound x, y, z, t: one per operator call (or
+    // definition being recorded).  Lookups of x/y/z/t check the top frame first.
+    struct Frame {
+        double registers[4];  // x, y, z, t
+        unsigned bound;       // Bit i set when registers[i] holds a value
+    };
+    std::vector<Frame> frames_;
+    size_t recordingFrame_;  // frames_.size() after the recording snapshot was pushed (0 = none)
+    Frame bindFrame() const;  // x, y, z, t bound to the top 4 stack values
+    void pushFrame() { frames_.push_back(bindFrame()); }
+    void endRecordingFrame();
+    static int registerIndex(std::string_view name);  // x=0, y=1, z=2, t=3, else -1
+    const double* findRegister(int index) const;        // nullptr if unbound
+
+    // Array table, indexed by handle.  Entries are shared with copies of the
+    // calculator; slots nothing refers to are freed between lines.
+    std::vector<std::shared_ptr<const std::vector<double>>> arrays_;  // null = free
+    std::vector<std::uint32_t> freeArrays_;
+    size_t liveArrays_;  // While zero no operand can be an array
+    bool broadcast(const Operator& op);  // Apply op element-wise if an operand is an array
+    void sweepArrays();                  // Free arrays no root refers to
+    void loadArray(std::string_view path);  // "<path": numbers separated by blanks or commas
+    std::string_view formatArray(double handle) const;
+
+    // Operator dispatch.  Call sites run op.execute directly unless arrays
+    // exist or profiling is on, in which case they go through callOperator.
+    void callOperator(const Operator& op);
+    void applyScalar(const Operator& op);  // VM: Operator::scalar on the stack (bytecode.cpp)
+
+    // Per-operator profile (profile.cpp), indexed by the name's SymbolId
+    struct ProfileEntry {
+        std::uint64_t calls = 0;
+        std::uint64_t totalNs = 0;  // Outermost activations, including callees
+        std::uint64_t selfNs = 0;   // Excluding profiled callees
+        int maxDepth = 0;           // Deepest user operator nesting seen
+        int active = 0;             // Activations currently running
+    };
+    struct ProfileFrame {
+        std::uint64_t start;        // steady_clock, ns
+        std::uint64_t childNs;      // Time spent in profiled callees
+    };
+    bool profiling_;
+    std::vector<ProfileEntry> profile_;
+    std::vector<ProfileFrame> profileFrames_;
+    std::vector<SymbolId> profiledOperators() const;  // Most self time first
+    bool handleProfileCommand(std::string_view stmt);  // prof [on|off|reset]
+    void printProfile();
+    void endProfile(SymbolId id);  // Finish the callOperator timing of a call
+
+    // Operator registry snapshot that names resolve against.  It is refreshed
+    // between lines; snapshots replaced by this calculator's own definitions
+    // mid-line are held until then, since their operators may still be running.
+    std::shared_ptr<const RegistrySnapshot> registry_;
+    std::vector<std::shared_ptr<const RegistrySnapshot>> heldRegistries_;
+    void refreshRegistry();  // Between lines
+    void repinRegistry();    // After this calculator changed the registry
+
+    // Compiled user-defined operators (bytecode.cpp)
+    bool deferCompile_;  // Set while loadConfig registers operators in bulk
+    const CompiledCode* compileProgram(Program& program);  // Against registry_
+    void compileToken(Instruction& ins);
+    void compileUserOperators();  // Recompile any stale user operator programs
+    const CompiledCode* currentBuild(Program& program);  // Compiles it if stale
+
+    // Call stack (bytecode.cpp).  Operator and temporary operator bodies run
+    // as activations on calls_ rather than as C++ recursion: a call made
+    // while runCalls() is driving the stack only pushes one, so nesting is
+    // bounded by callStackBudget_ and not by the thread's stack.
+    enum class CallKind : std::uint8_t {
+        BODY,      // Runs in the caller's frame (CSV column expressions)
+        OPERATOR,  // User-defined operator: own frame, counted in callDepth_
+        MACRO      // Temporary operator: own frame, counted in macroDepth_
+    };
+    struct Activation {
+        Program* program;
+        const CompiledCode* code;  // Stale once the body changes the registry
+        size_t ip;                 // Next instruction, which is also the token index
+        size_t frameDepth;         // frames_.size() at entry
+        size_t loopDepth;          // loopCounts_.size() at entry
+        SymbolId profileId;        // Profiled call to finish on return (kNoSymbol = none)
+        CallKind kind;
+    };
+    static constexpr size_t kDefaultCallStackMB = 256;  // Millions of calls
+    std::vector<Activation> calls_;
+    std::vector<MacroBody> runningMacros_;  // Held alive while their activations run
+    std::vector<std::uint64_t> loopCounts_;  // Iterations left in each running "times" loop
+    static constexpr double kMaxLoopCount = 1e9;  // Larger "times" counts are refused
+    bool runningCalls_;
+    size_t callStackBudget_;  // Bytes calls_, frames_ and loopCounts_ may use ("callstack" MB in ~/.rpn)
+    std::string callToken_;   // Outermost call, to annotate its quietops result
+    void enterCall(Program& program, CallKind kind, std::string_view token,
+                   SymbolId profileId = kNoSymbol);
+    void runCalls();  // Until calls_ is empty
+    void abandonCalls();  // Every activation returns at its next step
+    // Ctrl-C while run() evaluates a line.  Checked on loop back-edges and
+    // tail calls, the places a body can spin forever without nesting.
+    static volatile std::sig_atomic_t interrupted_;
+    bool interruptCalls();  // Abandons the running calls if interrupted
+    void returnFromCall();
+    void runProgram(Program& program);  // A BODY call, run to completion
+    void callUserOperator(Program& program, SymbolId profileId = kNoSymbol);
     
     // Helper methods
     void removeTrailingZeros();
-    void loadConfig();
+    void loadConfig();                          // From the binary cache when it is current (config.cpp)
+    void applyConfig(std::string_view records);  // Settings and definitions parsed from the config
+    void reloadConfig();                        // Daemon: start over from a changed config
+
+    // The config file loadConfig read, to notice when it changes (config.cpp)
+    struct ConfigStamp {
+        std::string path;  // Empty: there was none
+        std::uint64_t device = 0, inode = 0, size = 0;
+        std::int64_t mtimeSec = 0, mtimeNsec = 0;
+    };
+    ConfigStamp configStamp_;
+    static ConfigStamp stampOf(const std::string& path, const struct stat& st);
+    bool configChanged() const;
     void detectLocaleSeparators();
+    enum class NumberParse { INVALID, OK, OUT_OF_RANGE };
+    NumberParse parseNumber(std::string_view token, double& value) const;
     bool isNumber(const std::string& token) const;
-    std::string normalizeNumber(const std::string& token) const;
-    std::string extractOperator(const std::string& token, size_t& opStart) const;
+    // The view refers to storage owned by registry_ (or a string literal)
+    std::string_view extractOperator(std::string_view token, size_t& opStart) const;
 
     // Locale settings
     char decimalSeparator_;
@@ -118,22 +279,69 @@ private:
     bool localeFormatting_;  // Format output with locale separators (on by default)
     std::string outputPrefix_;  // Prefix for print() output (e.g., "\t→ ")
     bool autobindXYZ_;  // Auto-bind x, y, z in user operators (on by default)
+
+    // Quiet modes: suppressed prints return before formatting anything
+    bool quiet_;           // Only print the final stack top of each line (and explicit p)
+    bool quietPinned_;     // quiet_ was set on the command line
+    bool quietOperators_;  // Only print the result of each top-level operator call
+    mutable bool resultPending_;  // A print was suppressed since the last shown result
+    bool printSuppressed() const {
+        return quiet_ || (quietOperators_ && (callDepth_ > 0 || macroDepth_ > 0));
+    }
+    void writeValue(double value) const;  // Unconditional print
+    void printResult();                   // Show the stack top if a print was suppressed
     
     // Output tracking
     std::string currentToken_;  // Token currently being executed (for output annotation)
 
-    // Formatting helper
-    std::string formatNumber(double value) const;
+    // Formatting helper; the view points into formatBuffer_ and is only
+    // valid until the next call
+    std::string_view formatNumber(double value) const;
+    mutable char formatBuffer_[96];
+    mutable std::string arrayBuffer_;  // formatArray() output
+
+    OutputSink* out_;  // Not owned
+    bool streaming_;   // stream(): stdout carries only results, status goes to stderr
+    bool sharedRegistry_;  // Parallel worker: lines must not change the shared operator set
+    void streamLine(std::string_view line, bool carryStack);  // Evaluate and write one result line
+    void streamInput(std::FILE* in, bool carryStack, std::string_view head);  // head: input already read
+    bool sameSession(const RPNCalculator& other) const;  // Nothing a later line sees differs (batch.cpp)
+    std::string workingDir_;  // Daemon connection: the client's directory, for relative paths
+    void serveClient(int fd);  // Evaluate one connection's request on this copy
 
     // Processing
+    // Statements and tokens are views into the caller's line buffer
     void processLine(const std::string& line);
-    void processStatement(const std::string& statement);
-    void processToken(std::string token);
+    void processStatements(std::string_view line);  // Split on ';' and run each statement
+    void processStatement(std::string_view statement);
+    void processToken(std::string_view token);
 
-    // Decomposed handlers (refactor of processToken)
-    bool handleMeta(const std::string& token);      // assignment, operator start/stop, playback
-    bool handleSpecial(const std::string& token);   // sto, rcl, scale, fmt
-    bool handleInlineNumericOp(const std::string& token); // e.g., "45tan", "3+"
+    // Decomposed handlers (refactor of processToken); token is already lowercase
+    bool handleMeta(std::string_view token);      // assignment, operator start/stop, playback
+    bool handleSpecial(std::string_view token);   // sto, rcl, scale, fmt
+    bool handleInlineNumericOp(std::string_view token); // e.g., "45tan", "3+"
 };
 
+// Every operator kernel runs these, so they are inline: operators compile
+// down to direct stack accesses and a flag test when printing is suppressed
+inline void RPNCalculator::pushStack(double value) {
+    stack_.push(value);
+}
+
+inline double RPNCalculator::popStack() {
+    return stack_.pop();
+}
+
+inline double RPNCalculator::peekStack(size_t level) const {
+    return stack_.peek(level);
+}
+
+inline void RPNCalculator::print(double value) const {
+    if (printSuppressed()) {
+        resultPending_ = true;
+        return;
+    }
+    writeValue(value);
+}
+
 #endif // RPN_H
@@ -0,0 +1,97 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef RPNSTACK_H
+#define RPNSTACK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Contiguous, indexable value stack.  Positions are addressed by level:
+// level 0 is the top (x), level 1 is y, and so on down to size() - 1.
+// Storage is bottom-first, so begin()/end() iterate bottom to top.  Values
+// below base_ have been trimmed from the bottom and are reclaimed lazily.
+class RPNStack {
+public:
+    using const_iterator = std::vector<double>::const_iterator;
+
+    bool empty() const { return values_.size() == base_; }
+    size_t size() const { return values_.size() - base_; }
+    void clear() {
+        values_.clear();
+        base_ = 0;
+    }
+
+    void push(double value) { values_.push_back(value); }
+
+    // Returns 0 if empty
+    double pop() {
+        if (empty()) return 0.0;
+        double value = values_.back();
+        values_.pop_back();
+        if (empty()) clear();
+        return value;
+    }
+
+    // Returns 0 for levels past the bottom
+    double peek(size_t level = 0) const {
+        return level < size() ? values_[values_.size() - 1 - level] : 0.0;
+    }
+
+    // Copy the value at level to the top
+    void pick(size_t level) { push(peek(level)); }
+
+    // Move the value at level to the top, shifting the levels above it down
+    void roll(size_t level) {
+        if (level == 0 || level >= size()) return;
+        auto first = values_.end() - 1 - level;
+        std::rotate(first, first + 1, values_.end());
+    }
+
+    // Move the top value down to level (inverse of roll)
+    void rollDown(size_t level) {
+        if (level == 0 || level >= size()) return;
+        auto first = values_.end() - 1 - level;
+        std::rotate(first, values_.end() - 1, values_.end());
+    }
+
+    // Drop the run of zeros at the bottom by advancing the base offset;
+    // costs O(trimmed) plus amortized compaction.  Returns the number removed
+    size_t trimBottomZeros() {
+        size_t start = base_;
+        while (base_ < values_.size() && values_[base_] == 0.0) {
+            base_++;
+        }
+        size_t trimmed = base_ - start;
+        if (empty()) {
+            clear();
+        } else if (base_ > size()) {
+            // More dead than live slots: reclaim them (paid for by the trims)
+            values_.erase(values_.begin(), values_.begin() + base_);
+            base_ = 0;
+        }
+        return trimmed;
+    }
+
+    const_iterator begin() const { return values_.begin() + base_; }
+    const_iterator end() const { return values_.end(); }
+
+private:
+    std::vector<double> values_;
+    size_t base_ = 0;  // Index of the bottom value in values_
+};
+
+#endif // RPNSTACK_H
@@ -0,0 +1,83 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "symbols.h"
+#include <functional>
+
+// Singleton instance
+SymbolTable& SymbolTable::instance() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolId SymbolTable::intern(std::string_view name) {
+    SymbolId id = find(name);
+    if (id != kNoSymbol) return id;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Buckets* table = buckets_.load(std::memory_order_relaxed);
+    size_t count = size_.load(std::memory_order_relaxed);
+    if (!table || (count + 1) * 2 > table->mask + 1) {
+        table = grow(table);
+    }
+    size_t bucket = probe(*table, name);
+    id = table->slots[bucket].load(std::memory_order_relaxed);
+    if (id != kNoSymbol) return id;  // Added by another thread since find()
+
+    // Store the name before publishing its ID
+    id = static_cast<SymbolId>(count);
+    if ((count & (kChunkSize - 1)) == 0) {
+        chunks_[count >> kChunkBits].reset(new std::string[kChunkSize]);
+    }
+    chunks_[count >> kChunkBits][count & (kChunkSize - 1)] = std::string(name);
+    size_.store(count + 1, std::memory_order_release);
+    table->slots[bucket].store(id, std::memory_order_release);
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view name) const {
+    const Buckets* table = buckets_.load(std::memory_order_acquire);
+    if (!table) return kNoSymbol;
+    return table->slots[probe(*table, name)].load(std::memory_order_acquire);
+}
+
+size_t SymbolTable::probe(const Buckets& table, std::string_view name) const {
+    size_t bucket = std::hash<std::string_view>()(name) & table.mask;
+    for (;;) {
+        SymbolId id = table.slots[bucket].load(std::memory_order_acquire);
+        if (id == kNoSymbol || this->name(id) == name) return bucket;
+        bucket = (bucket + 1) & table.mask;
+    }
+}
+
+// Called with mutex_ held
+const SymbolTable::Buckets* SymbolTable::grow(const Buckets* table) {
+    size_t count = table ? (table->mask + 1) * 2 : 256;
+    auto next = std::make_unique<Buckets>();
+    next->mask = count - 1;
+    next->slots.reset(new std::atomic<SymbolId>[count]);
+    for (size_t i = 0; i < count; ++i) {
+        next->slots[i].store(kNoSymbol, std::memory_order_relaxed);
+    }
+    size_t size = size_.load(std::memory_order_relaxed);
+    for (size_t id = 0; id < size; ++id) {
+        next->slots[probe(*next, name(static_cast<SymbolId>(id)))].store(
+            static_cast<SymbolId>(id), std::memory_order_relaxed);
+    }
+    const Buckets* published = next.get();
+    tables_.push_back(std::move(next));
+    buckets_.store(published, std::memory_order_release);
+    return published;
+}
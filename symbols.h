@@ -0,0 +1,73 @@
+// Copyright (C) 2026  Rob Altenburg <rca@qrpc.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Small integer handle for an interned name
+using SymbolId = std::uint32_t;
+constexpr SymbolId kNoSymbol = static_cast<SymbolId>(-1);
+
+// Process-wide name interning.  Each distinct name is hashed once to get a
+// dense ID; operators, variables and temporary operators are then stored in
+// arrays indexed by that ID.  IDs are never reused or removed.
+//
+// find() and name() are lock-free and may run on any thread alongside
+// intern(), which serializes on a mutex.  Names live in fixed-size chunks
+// that never move; a grown bucket array is published by pointer and the old
+// one is kept alive for readers still probing it.
+class SymbolTable {
+public:
+    static SymbolTable& instance();
+
+    SymbolId intern(std::string_view name);      // Adds the name on first use
+    SymbolId find(std::string_view name) const;  // kNoSymbol if never interned
+    const std::string& name(SymbolId id) const {
+        return chunks_[id >> kChunkBits][id & (kChunkSize - 1)];
+    }
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+
+private:
+    SymbolTable() = default;
+
+    static constexpr size_t kChunkBits = 12;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+    static constexpr size_t kMaxChunks = 4096;  // 16M names
+
+    // Open-addressed hash of IDs probed with string_view keys, so lookups
+    // never build a temporary std::string
+    struct Buckets {
+        size_t mask;  // Bucket count - 1 (a power of two)
+        std::unique_ptr<std::atomic<SymbolId>[]> slots;  // kNoSymbol = empty
+    };
+    size_t probe(const Buckets& table, std::string_view name) const;  // Bucket holding name, or the empty one ending its chain
+    const Buckets* grow(const Buckets* table);
+
+    std::unique_ptr<std::string[]> chunks_[kMaxChunks];
+    std::atomic<size_t> size_{0};
+    std::atomic<const Buckets*> buckets_{nullptr};
+    std::vector<std::unique_ptr<Buckets>> tables_;  // Current and retired bucket arrays
+    std::mutex mutex_;
+};
+
+#endif // SYMBOLS_H
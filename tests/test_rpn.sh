@@ -0,0 +1,121 @@
+#!/usr/bin/env bash
+# Behaviour tests for the rpn binary: ./tests/test_rpn.sh [path/to/rpn]
+#
+# Each check runs rpn in a scratch directory with its own HOME, so neither
+# ./.rpn nor ~/.rpn of the person running the tests is read or written.
+
+RPN=$(cd "$(dirname "${1:-./rpn}")" && pwd)/$(basename "${1:-./rpn}")
+WORK=$(mktemp -d)
+trap 'kill "$DAEMON" 2>/dev/null; rm -rf "$WORK"' EXIT
+export HOME="$WORK/home"
+export RPN_SOCKET="$WORK/rpn.sock"
+mkdir -p "$HOME"
+cd "$WORK" || exit 1
+
+failures=0
+checks=0
+
+# check NAME EXPECTED ACTUAL
+check() {
+    checks=$((checks + 1))
+    if [ "$2" != "$3" ]; then
+        failures=$((failures + 1))
+        echo "FAIL: $1"
+        echo "  expected: $(printf '%q' "$2")"
+        echo "  actual:   $(printf '%q' "$3")"
+    fi
+}
+
+# Final result of -q -e, without the output prefix
+result() {
+    "$RPN" -q -e "$1" 2>/dev/null | tail -n 1 | sed 's/^\t→ //'
+}
+
+# --- Expressions -------------------------------------------------------------
+check "arithmetic" "5" "$(result '2 3 +')"
+check "inline operator" "9" "$(result '3 3*')"
+check "precedence of tokens" "14" "$(result '2 3 4 * +')"
+check "statements" "6" "$(result '1 2 + ; 2 *')"
+check "variables" "12" "$(result '4 a= ; a 3 *')"
+check "temporary operator" "10" "$(result 'dbl[ 2 * ] ; 5 dbl')"
+check "-q anywhere" "$(printf '\t→ 5')" "$("$RPN" -e '2 3 +' -q 2>/dev/null)"
+check "arrays" "[1 4 9 16 25]" "$(result '1 5 range 2 ^')"
+
+# --- Operators, control flow and the journal -----------------------------------
+"$RPN" -e 'down{ d 0 > if 1 - down then }' >/dev/null 2>&1
+"$RPN" -e 'count{ 0 swap times 1 + loop }' >/dev/null 2>&1
+"$RPN" -e 'halve{ begin d 1 > while 2 / repeat }' >/dev/null 2>&1
+check "journaled definition" "operator down User-defined : d 0 > if 1 - down then" \
+      "$(grep '^operator down' "$HOME/.rpn")"
+check "if/then with tail recursion" "0" "$(result '100000 down')"
+check "times/loop" "7" "$(result '7 count')"
+check "begin/while/repeat" "1" "$(result '64 halve')"
+check "loop count too large" "Error: Loop count too large" \
+      "$(timeout 10 "$RPN" -q -e '1e300 count' 2>&1 >/dev/null)"
+check "comparison" "1" "$(result '3 2 >')"
+check "definition from cache" "7" "$(result '7 count')"
+"$RPN" -e 'count{}' >/dev/null 2>&1
+check "deleted definition" "" "$("$RPN" -q -e '7 count' 2>/dev/null | grep -v '→ 7')"
+
+# A hand-written mixed-case definition, deleted, then compacted away
+echo 'operator Twice User-defined : 2 *' >> "$HOME/.rpn"
+check "mixed-case definition" "10" "$(result '5 twice')"
+"$RPN" -e 'twice{}' >/dev/null 2>&1
+for i in $(seq 1 70); do "$RPN" -e "bump{ $i + }" >/dev/null 2>&1; done
+check "compaction drops superseded lines" "yes" \
+      "$([ "$(grep -c '^operator bump' "$HOME/.rpn")" -lt 70 ] && echo yes)"
+check "compaction keeps the latest definition" "75" "$(result '5 bump')"
+check "compaction keeps the deletion" "" "$(grep -i '^operator twice' "$HOME/.rpn")"
+check "deleted after compaction" "Error: Invalid input 'twice'" "$("$RPN" -q -e '5 twice' 2>&1 >/dev/null)"
+
+# --- --stream, --carry and --jobs -----------------------------------------------
+printf '1 2 +\n\n4 5 *\n' > lines.txt
+check "--stream" "$(printf '3\n\n20')" "$("$RPN" --stream < lines.txt 2>/dev/null)"
+check "--stream --carry" "$(printf '3\n3\n20')" "$("$RPN" --stream --carry < lines.txt 2>/dev/null)"
+
+# Lines that define state for later lines, spread over many chunks
+{
+    echo 'm[ 2 * ]'
+    for i in $(seq 1 60000); do echo "$i m"; done
+    echo '7 a='
+    for i in $(seq 1 60000); do echo "a $i +"; done
+    echo '2 fix'
+    for i in $(seq 1 20000); do echo "$i 3 /"; done
+} > state.txt
+"$RPN" --stream < state.txt > stream.out 2>/dev/null
+for jobs in 1 4 0; do
+    "$RPN" --stream --jobs "$jobs" < state.txt > jobs.out 2>/dev/null
+    check "--jobs $jobs matches --stream" "$(md5sum < stream.out)" "$(md5sum < jobs.out)"
+done
+for i in $(seq 1 100000); do echo "$i 2 * 1 +"; done > plain.txt
+"$RPN" --stream < plain.txt > stream.out 2>/dev/null
+"$RPN" --stream --jobs 4 < plain.txt > jobs.out 2>/dev/null
+check "--jobs 4 matches --stream (independent lines)" "$(md5sum < stream.out)" "$(md5sum < jobs.out)"
+
+# --- --csv ---------------------------------------------------------------------
+printf 'a,b\n1,2\n3,4\nx,5\n' > data.csv
+check "--csv" "$(printf 'a,b,result\n1,2,3\n3,4,7\nx,5,')" \
+      "$("$RPN" --csv data.csv --expr 'a b +' 2>/dev/null)"
+check "--csv row program" "$(printf 'a,b,result\n1,2,1\n3,4,3\nx,5,')" \
+      "$("$RPN" --csv data.csv --expr 'a b > if b else a then' 2>/dev/null)"
+check "--csv keeps printing out of the file" "$(printf 'a,b,result\n1,2,3\n3,4,7\nx,5,')" \
+      "$("$RPN" --csv data.csv --expr 'a b p +' 2>/dev/null)"
+
+# --- --daemon and --client ------------------------------------------------------
+"$RPN" --daemon >/dev/null 2>&1 &
+DAEMON=$!
+for _ in $(seq 1 50); do [ -S "$RPN_SOCKET" ] && break; sleep 0.1; done
+check "--client" "$(printf '\t→ 12')" "$("$RPN" --client -q -e '3 4 *' 2>/dev/null)"
+"$RPN" -e 'tw{ 2 * }' >/dev/null 2>&1
+check "--client sees operators defined after the daemon started" "$(printf '\t→ 10')" "$("$RPN" --client -q -e '5 tw' 2>/dev/null)"
+"$RPN" --client -e 'th{ 3 * }' >/dev/null 2>&1
+check "--client defines operators locally" "$(printf '\t→ 15')" "$("$RPN" --client -q -e '5 th' 2>/dev/null)"
+"$RPN" --client -e 'th{ }' >/dev/null 2>&1
+check "--client deletes operators locally" "gone" "$(grep -q '^delete th$' "$HOME/.rpn" && "$RPN" --client -q -e '5 th' 2>&1 | grep -q Invalid && echo gone)"
+kill -INT "$DAEMON"
+wait "$DAEMON" 2>/dev/null
+check "daemon removes its socket" "gone" "$([ -e "$RPN_SOCKET" ] || echo gone)"
+check "--client without a daemon" "$(printf '\t→ 12')" "$("$RPN" --client -q -e '3 4 *' 2>/dev/null)"
+
+echo "$((checks - failures))/$checks checks passed"
+[ "$failures" -eq 0 ]